@@ -0,0 +1,187 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asm/asm.hpp"
+#include "aot/aot.hpp"
+#include "core/interpreter.hpp"
+
+/*
+ * Runs an assembly program with every engine and compares the registers they leave behind.
+ *
+ *     engines program.asm [cc]
+ *     engines program.bin [cc]
+ *
+ * Binaries are run as they are, older image versions can only be tested this way, the assembler writes the current one.
+ * The switch dispatch with pinned registers is the reference. If a C compiler is passed, the program is also
+ * translated ahead of time, compiled into a shared library and run natively. Returns 0 if every engine agrees.
+ * A program that raises an exception has to raise the same one with every engine.
+**/
+
+using namespace vman;
+using namespace vman::core;
+
+namespace
+{
+	struct Registers
+	{
+		std::array<s32, 12> r;
+		std::array<s64, 12> x;
+		std::array<f64, 12> f;
+		std::string exception;
+	};
+
+	Registers Run(const std::shared_ptr<const Executable>& executable, Dispatch dispatch, bool pin)
+	{
+		Instance instance(executable);
+		instance.SetDispatch(dispatch);
+		instance.SetPinRegisters(pin);
+		instance.Execute();
+
+		return { instance.GetRegisters(), instance.GetWideRegisters(), instance.GetFloatRegisters(), instance.GetException() };
+	}
+
+	// Prints every register that differs from the reference, returns the number of them.
+	int Compare(const std::string& engine, const Registers& reference, const Registers& registers)
+	{
+		int differences = 0;
+
+		if (registers.exception != reference.exception)
+		{
+			std::cerr << "[ERROR] " << engine << ": the exception is \"" << registers.exception << "\" instead of \"" << reference.exception << "\".\n";
+			++differences;
+		}
+
+		for (std::size_t i = 0; i < 12; ++i)
+		{
+			if (registers.r[i] != reference.r[i])
+			{
+				std::cerr << "[ERROR] " << engine << ": r" << i << " is " << registers.r[i] << " instead of " << reference.r[i] << ".\n";
+				++differences;
+			}
+
+			if (registers.x[i] != reference.x[i])
+			{
+				std::cerr << "[ERROR] " << engine << ": x" << i << " is " << registers.x[i] << " instead of " << reference.x[i] << ".\n";
+				++differences;
+			}
+
+			// Bitwise, so a NaN equals the same NaN
+			if (std::memcmp(&registers.f[i], &reference.f[i], sizeof(f64)) != 0)
+			{
+				std::cerr << "[ERROR] " << engine << ": f" << i << " is " << registers.f[i] << " instead of " << reference.f[i] << ".\n";
+				++differences;
+			}
+		}
+
+		return differences;
+	}
+
+	/*
+	 * Translates the program into C and compiles it into a shared library next to the temporary files.
+	 * Returns nullptr if the library can't be built or loaded.
+	**/
+	std::shared_ptr<const Executable> Compile(const std::shared_ptr<const Executable>& executable, const std::string& name, const std::string& compiler)
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path();
+		const std::string source = (directory / ("vman-engines-" + name + ".c")).string();
+		const std::string library = (directory / ("vman-engines-" + name + ".so")).string();
+
+		vman::aot::Translator translator;
+		translator.Translate(executable->Code(), executable->Bytes());
+
+		std::ofstream(source, std::ios::binary) << translator.Source();
+
+		const std::string command = "\"" + compiler + "\" -O2 -shared -fPIC \"" + source + "\" -o \"" + library + "\"";
+		if (std::system(command.c_str()) != 0)
+		{
+			std::cerr << "[ERROR] Couldn't compile " << source << ".\n";
+			return nullptr;
+		}
+
+		return Executable::Open(library);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr << "No file passed. USAGE: engines program.asm|program.bin [cc]\n";
+		return -1;
+	}
+
+	std::shared_ptr<const Executable> executable;
+	if (std::filesystem::path(argv[1]).extension() == ".bin") executable = Executable::Open(argv[1]);
+	else
+	{
+		std::ifstream file(argv[1], std::ios::binary);
+		const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		vasm::Assembler assembler;
+		if (!file || !assembler.Assemble(text)) return -1;
+
+		executable = Executable::Create(Image(std::vector<char>(assembler.Binary())));
+	}
+	if (!executable) return -1;
+
+	struct Engine
+	{
+		const char* name;
+		Dispatch dispatch;
+		bool pin;
+	};
+
+	static constexpr Engine engines[] =
+	{
+		{ "threaded, pinned registers", Dispatch::Threaded, true },
+		{ "jit, pinned registers", Dispatch::Jit, true },
+		{ "switch, registers in memory", Dispatch::Switch, false },
+		{ "threaded, registers in memory", Dispatch::Threaded, false },
+		{ "jit, registers in memory", Dispatch::Jit, false }
+	};
+
+	const Registers reference = Run(executable, Dispatch::Switch, true);
+	int differences = 0;
+
+	for (const Engine& engine : engines) differences += Compare(engine.name, reference, Run(executable, engine.dispatch, engine.pin));
+
+	if (argc > 2)
+	{
+		const auto compiled = Compile(executable, std::filesystem::path(argv[1]).stem().string(), argv[2]);
+		if (!compiled) return -1;
+
+		differences += Compare("aot", reference, Run(compiled, Dispatch::Switch, true));
+	}
+
+	std::cout << argv[1] << ": " << differences << " differences.\n";
+	return differences == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+; Edge cases of DIV and MOD, every engine has to leave the same registers behind.
+; The quotient of INT_MIN and -1 doesn't fit, it wraps around to INT_MIN, the remainder is 0.
+
+        .code
+        mov r10, 0x80000000
+        mov r11, -1
+        div r0, r10, r11
+        mod r1, r10, r11
+        mov r9, 0x7fffffff
+        div r2, r9, r11
+        mov r8, -7
+        mov r7, 2
+        div r3, r8, r7
+        mod r4, r8, r7
+        mov r7, -2
+        mov r8, 7
+        mod r5, r8, r7
+
+        ; The divisor of -1 inside a loop, the JIT has to leave its compiled code for it on every iteration.
+        mov r6, 0x80000000
+        mov r7, 0
+        mov r8, 5
+        mov r9, 1
+        mov r11, loop
+loop:   mov r10, -1
+        div r6, r6, r10
+        mod r10, r6, r10
+        add r7, r7, r6
+        sub r8, r8, r9
+        mov r10, 0
+        jne r8, r10, r11
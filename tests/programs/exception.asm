@@ -0,0 +1,14 @@
+; A division by zero inside a loop stops the program, the registers keep the values they had at that point.
+; Every engine has to report the same exception and leave the same registers behind.
+
+        .code
+        mov r0, 0
+        mov r1, 3
+        mov r2, 1
+        mov r3, 100
+        mov r11, loop
+loop:   add r0, r0, r2
+        div r4, r3, r1
+        sub r1, r1, r2
+        mov r10, -5
+        jne r1, r10, r11
@@ -0,0 +1,40 @@
+; Overflowing 32 and 64 bit arithmetic and shift counts outside of the register width.
+; Additions, subtractions and multiplications wrap around, shift counts are taken modulo the width.
+
+        .code
+        mov r10, 0x7fffffff
+        mov r11, 0x80000000
+        mov r9, 1
+        add r0, r10, r9
+        sub r1, r11, r9
+        mov r8, 0x10001
+        mul r2, r8, r8
+        mul r2, r2, r10
+        mov r8, 33
+        lsh r3, r10, r8
+        mov r8, -31
+        rsh r4, r11, r8
+        mov r8, 32
+        lsh r5, r10, r8
+
+        movx x10, 0x7fffffffffffffff
+        movx x11, 1
+        addx x0, x10, x11
+        subx x1, x0, x11
+        mulx x2, x10, x10
+        movx x9, 65
+        lshx x3, x10, x9
+        movx x9, -1
+        rshx x4, x0, x9
+
+        ; Fused pairs wrap like single instructions, the sum runs through INT_MAX.
+        mov r6, 0x7ffffff0
+        mov r7, 0
+        mov r8, 32
+        mov r9, 1
+        mov r11, loop
+loop:   add r6, r6, r9
+        add r7, r7, r6
+        sub r8, r8, r9
+        mov r10, 0
+        jne r8, r10, r11
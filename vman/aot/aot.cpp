@@ -0,0 +1,548 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "aot.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "../core/opcodes.hpp"
+#include "../core/verifier.hpp"
+#include "../core/native.hpp"
+#include "../vmb/vmb.hpp"
+
+using vman::aot::Translator;
+
+using namespace vman;
+using namespace vman::core;
+
+namespace
+{
+	/*
+	 * The parts of the generated source that don't depend on the program. struct vman_host has to match NativeHost.
+	**/
+	constexpr const std::string_view PREAMBLE =
+		"#include <stdint.h>\n"
+		"#include <string.h>\n"
+		"\n"
+		"#if defined (_WIN32)\n"
+		"#define VMAN_EXPORT __declspec(dllexport)\n"
+		"#else\n"
+		"#define VMAN_EXPORT __attribute__((visibility(\"default\")))\n"
+		"#endif\n"
+		"\n"
+		"struct vman_result\n"
+		"{\n"
+		"\tint64_t integer;\n"
+		"\tdouble real;\n"
+		"};\n"
+		"\n"
+		"struct vman_host\n"
+		"{\n"
+		"\tvoid* context;\n"
+		"\tvoid* const* imports;\n"
+		"\tchar* memory;\n"
+		"\tvoid* (*resolve)(void* context, uint32_t site, uint32_t library, uint32_t function);\n"
+		"\tstruct vman_result (*call)(void* context, uint32_t site, void* function, const void* const* values);\n"
+		"\tstruct vman_result (*vector)(void* context, uint32_t index, const int32_t* values);\n"
+		"\tvoid (*raise)(void* context, int32_t error, int32_t reg, int64_t value);\n"
+		"};\n"
+		"\n"
+		"/* Values inside the image don't have to be aligned. */\n"
+		"static inline int vman_int(const char* value) { int result; memcpy(&result, value, sizeof(result)); return result; }\n"
+		"static inline long long vman_long_long(const char* value) { long long result; memcpy(&result, value, sizeof(result)); return result; }\n"
+		"static inline double vman_bits(uint64_t bits) { double result; memcpy(&result, &bits, sizeof(result)); return result; }\n"
+		"\n"
+		"/* Rounds towards zero, NaN becomes 0 and values out of range saturate, like FTOI in the interpreter. */\n"
+		"static inline int64_t vman_truncate(double value)\n"
+		"{\n"
+		"\tif (value != value) return 0;\n"
+		"\tif (value >= 9223372036854775807.0) return INT64_MAX;\n"
+		"\tif (value <= -9223372036854775808.0) return INT64_MIN;\n"
+		"\treturn (int64_t)value;\n"
+		"}\n"
+		"\n"
+		"#define VMAN_RAISE(error, reg, value) do { VMAN_SPILL(); host->raise(host->context, error, reg, value); return -1; } while (0)\n"
+		"#define VMAN_RESULT(integer, real) (x2 = (integer), r2 = (int32_t)x2, f2 = (real))\n"
+		"#define VMAN_WRAP(x) ((int32_t)(uint32_t)(x))\n"
+		"#define VMAN_WRAP64(x) ((int64_t)(uint64_t)(x))\n"
+		"#define VMAN_COMPARE(a, b) ((a) < (b) ? -1 : (a) > (b) ? 1 : (a) == (b) ? 0 : 2)\n"
+		"\n"
+		"/* Accesses outside of the linear memory fault inside its reserved range, the host turns that into an exception. */\n"
+		"#define VMAN_LOAD(target, type, address) do { type value_; memcpy(&value_, memory + (uint32_t)(address), sizeof(value_)); target = value_; } while (0)\n"
+		"#define VMAN_STORE(type, address, value) do { type value_ = (type)(value); memcpy(memory + (uint32_t)(address), &value_, sizeof(value_)); } while (0)\n"
+		"\n";
+
+	struct Bank
+	{
+		char prefix;
+		const char* type;
+		const char* array;
+	};
+
+	constexpr const Bank BANKS[] = { { 'r', "int32_t", "registers" }, { 'x', "int64_t", "wide" }, { 'f', "double", "floats" } };
+
+	// The name of a register operand, the opcode tells its bank.
+	std::string Operand(const Instruction& ins, std::size_t operand)
+	{
+		const u8 registers[] = { ins.a, ins.b, ins.c };
+		return RegisterBank(OPCODES[ins.opcode], operand) + std::to_string(registers[operand]);
+	}
+
+	std::string Label(u32 index)
+	{
+		return "L" + std::to_string(index);
+	}
+
+	// INT32_MIN can't be written as a negative literal, its magnitude doesn't fit into an int.
+	std::string Immediate(s32 value)
+	{
+		if (value == INT32_MIN) return "(-2147483647 - 1)";
+		return std::to_string(value);
+	}
+
+	std::string Hex64(u64 value)
+	{
+		std::string digits = "UINT64_C(0x";
+		for (int shift = 60; shift >= 0; shift -= 4) digits += "0123456789abcdef"[(value >> shift) & 0xF];
+		return digits + ")";
+	}
+
+	// The C type of a value that gets passed to or returned from a direct call, empty if the type has no direct call.
+	std::string_view CType(int type)
+	{
+		switch (type)
+		{
+			case vmb::Bridge::VMBINT: return "int";
+			case vmb::Bridge::VMBLONG_LONG: return "long long";
+			case vmb::Bridge::VMBDOUBLE: return "double";
+			case vmb::Bridge::VMBPOINTER: return "void*";
+			case vmb::Bridge::VMBVOID: return "void";
+			default: return {};
+		}
+	}
+
+	/*
+	 * Every jump target gets a label. If any jump takes its target from a register at runtime,
+	 * every instruction can be a target and needs one.
+	**/
+	std::vector<bool> Labels(const Program& program, bool& dispatch)
+	{
+		std::vector<bool> labels(program.code.size(), false);
+		labels[program.entry] = true;
+		dispatch = false;
+
+		for (const Instruction& ins : program.code)
+		{
+			if (ins.opcode != JMP && ins.opcode != JIE && ins.opcode != JNE) continue;
+
+			if (static_cast<u32>(ins.imm) != INVALID_INDEX) labels[ins.imm] = true;
+			else dispatch = true;
+		}
+
+		if (dispatch) labels.assign(program.code.size(), true);
+		return labels;
+	}
+};
+
+void Translator::EmitPrologue(const Image& fileBytes)
+{
+	source += "/*\n";
+	source += " * Generated by \"vman -c\", the program of a virtual man binary translated to C.\n";
+	source += " * Build it as a shared library and run that library with \"vman -e\":\n";
+	source += " *\n";
+	source += " *     cc -O2 -shared -fPIC program.c -o program.so\n";
+	source += " *     cl /O2 /LD program.c\n";
+	source += "**/\n\n";
+	source += PREAMBLE;
+
+	/*
+	 * Writes every register of the three banks back, before the program ends or raises an exception.
+	**/
+	source += "#define VMAN_SPILL() (";
+	for (const Bank& bank : BANKS)
+	{
+		source += " \\\n\t";
+		for (std::size_t i = 0; i < REGISTER_COUNT; ++i)
+		{
+			source += std::string(bank.array) + "[" + std::to_string(i) + "] = " + bank.prefix + std::to_string(i);
+			source += bank.prefix == 'f' && i + 1 == REGISTER_COUNT ? ")\n\n" : ", ";
+		}
+	}
+
+	source += "#define VMAN_IMAGE_SIZE " + std::to_string(fileBytes.size()) + "u\n\n";
+	source += "VMAN_EXPORT const uint32_t vman_abi = " + std::to_string(NATIVE_ABI) + ";\n";
+	source += "VMAN_EXPORT const uint32_t vman_image_size = VMAN_IMAGE_SIZE;\n";
+	source += "VMAN_EXPORT const unsigned char vman_image[VMAN_IMAGE_SIZE] =\n{";
+
+	for (std::size_t i = 0; i < fileBytes.size(); ++i)
+	{
+		source += i % 16 == 0 ? "\n\t" : " ";
+
+		const u8 byte = static_cast<u8>(fileBytes[i]);
+		source += "0x";
+		source += "0123456789abcdef"[byte >> 4];
+		source += "0123456789abcdef"[byte & 0xF];
+		source += ',';
+	}
+	source += "\n};\n\n";
+}
+
+void Translator::EmitNativeCall(const Program& program, const Instruction& ins)
+{
+	const u32 site = static_cast<u32>(ins.imm);
+	const CallSite& callSite = program.callSites[site];
+	const vmb::Bridge::CallPlan plan = vmb::Bridge::Plan(callSite.returnType, callSite.paramTypes, callSite.paramCount);
+	const std::string siteText = std::to_string(site) + "u";
+
+	/*
+	 * The interpreter refuses calls with an unsupported return type, the host prints the same error.
+	**/
+	if (plan.caller == nullptr)
+	{
+		source += "\thost->call(host->context, " + siteText + ", 0, 0);\n";
+		return;
+	}
+
+	source += "\t{\n";
+	if (ins.opcode == NFCI)
+	{
+		source += "\t\tvoid* function = host->imports[" + siteText + "];\n";
+	}
+	else
+	{
+		source += "\t\tvoid* function = host->resolve(host->context, " + siteText + ", (uint32_t)r0, (uint32_t)r1);\n";
+		source += "\t\tif (function == 0) VMAN_RESULT(0, 0.0);\n";
+		source += "\t\telse\n";
+	}
+	source += "\t\t{\n";
+
+	/*
+	 * Parameters are either taken from the binary at the address in their r register, or from their x or f register.
+	**/
+	std::vector<std::string> values;
+	for (u8 i = 0; i < callSite.paramCount; ++i)
+	{
+		const int type = callSite.paramTypes[i];
+		const std::string reg = std::to_string(i + 2);
+
+		if (type & vmb::Bridge::VMBREGISTER)
+		{
+			const int base = type & ~vmb::Bridge::VMBREGISTER;
+			values.push_back((base == vmb::Bridge::VMBFLOAT || base == vmb::Bridge::VMBDOUBLE ? "&f" : "&x") + reg);
+			continue;
+		}
+
+		values.push_back("image + r" + reg);
+		if (callSite.verified) continue;
+
+		source += "\t\t\tif (r" + reg + " < 0 || (uint32_t)r" + reg + " > VMAN_IMAGE_SIZE - " + std::to_string(vmb::Bridge::ValueSize(type)) + "u) ";
+		source += "VMAN_RAISE(" + std::to_string(NATIVE_INVALID_PARAMETER) + ", " + reg + ", r" + reg + ");\n";
+	}
+
+	if (plan.direct != nullptr)
+	{
+		/*
+		 * The signature has a trampoline, so it can be written down in C as well and called without dyncall.
+		**/
+		std::string signature = std::string(CType(callSite.returnType)) + " (*)(";
+		std::string arguments;
+		for (u8 i = 0; i < callSite.paramCount; ++i)
+		{
+			const int type = callSite.paramTypes[i];
+			if (i != 0)
+			{
+				signature += ", ";
+				arguments += ", ";
+			}
+			signature += CType(type);
+
+			if (type == vmb::Bridge::VMBINT) arguments += "vman_int(" + values[i] + ")";
+			else if (type == vmb::Bridge::VMBLONG_LONG) arguments += "vman_long_long(" + values[i] + ")";
+			else arguments += "(void*)(" + values[i] + ")";
+		}
+		if (callSite.paramCount == 0) signature += "void";
+		signature += ")";
+
+		const std::string call = "((" + signature + ")function)(" + arguments + ")";
+		switch (callSite.returnType)
+		{
+			case vmb::Bridge::VMBVOID: source += "\t\t\t" + call + ";\n\t\t\tVMAN_RESULT(0, 0.0);\n"; break;
+			case vmb::Bridge::VMBDOUBLE: source += "\t\t\tf2 = " + call + ";\n\t\t\tVMAN_RESULT(vman_truncate(f2), f2);\n"; break;
+			case vmb::Bridge::VMBPOINTER: source += "\t\t\tVMAN_RESULT((int64_t)(uintptr_t)" + call + ", 0.0);\n"; break;
+			default: source += "\t\t\tVMAN_RESULT(" + call + ", 0.0);\n"; break;
+		}
+	}
+	else
+	{
+		std::string array = "0";
+		if (callSite.paramCount != 0)
+		{
+			source += "\t\t\tconst void* values[" + std::to_string(callSite.paramCount) + "] = { ";
+			for (u8 i = 0; i < callSite.paramCount; ++i)
+			{
+				source += (i != 0 ? ", " : "") + values[i];
+			}
+			source += " };\n";
+			array = "values";
+		}
+		source += "\t\t\tstruct vman_result result = host->call(host->context, " + siteText + ", function, " + array + ");\n";
+		source += "\t\t\tVMAN_RESULT(result.integer, result.real);\n";
+	}
+
+	source += "\t\t}\n";
+	source += "\t}\n";
+}
+
+void Translator::EmitInstruction(const Program& program, const Instruction& ins)
+{
+	const std::string a = Operand(ins, 0);
+	const std::string b = Operand(ins, 1);
+	const std::string c = Operand(ins, 2);
+
+	/*
+	 * Resolved jumps go straight to their label, the others pass their target to the dispatch switch.
+	**/
+	const auto jump = [&ins](u8 targetRegister)
+	{
+		if (static_cast<u32>(ins.imm) != INVALID_INDEX) return "goto " + Label(static_cast<u32>(ins.imm)) + ";";
+
+		const std::string reg = std::to_string(targetRegister);
+		return "{ target = r" + reg + "; targetRegister = " + reg + "; goto dispatch; }";
+	};
+
+	/*
+	 * Division and modulo raise the exception of the interpreter for a zero divisor, the minimum divided by -1 wraps instead of trapping.
+	**/
+	const auto divide = [&](NativeError error, const std::string& minusOne, const char* op)
+	{
+		source += "\tif (" + c + " == 0) VMAN_RAISE(" + std::to_string(error) + ", " + std::to_string(ins.c) + ", 0);\n";
+		source += "\t" + a + " = " + c + " == -1 ? " + minusOne + " : " + b + op + c + ";\n";
+	};
+
+	switch (ins.opcode)
+	{
+		case ADD: source += "\t" + a + " = VMAN_WRAP((uint32_t)" + b + " + (uint32_t)" + c + ");\n"; break;
+		case SUB: source += "\t" + a + " = VMAN_WRAP((uint32_t)" + b + " - (uint32_t)" + c + ");\n"; break;
+		case MUL: source += "\t" + a + " = VMAN_WRAP((uint32_t)" + b + " * (uint32_t)" + c + ");\n"; break;
+		case DIV: divide(NATIVE_DIVISION_BY_ZERO, "VMAN_WRAP(0u - (uint32_t)" + b + ")", " / "); break;
+		case MOD: divide(NATIVE_DIVISION_BY_ZERO, "0", " % "); break;
+		case LSH: source += "\t" + a + " = VMAN_WRAP((uint32_t)" + b + " << (" + c + " & 31));\n"; break;
+		case RSH: source += "\t" + a + " = " + b + " >> (" + c + " & 31);\n"; break;
+		case NOT: source += "\t" + a + " = ~" + b + ";\n"; break;
+		case AND: source += "\t" + a + " = " + b + " & " + c + ";\n"; break;
+		case OR: source += "\t" + a + " = " + b + " | " + c + ";\n"; break;
+		case XOR: source += "\t" + a + " = " + b + " ^ " + c + ";\n"; break;
+		case MOV: source += "\t" + a + " = " + Immediate(ins.imm) + ";\n"; break;
+
+		case ADDX: source += "\t" + a + " = VMAN_WRAP64((uint64_t)" + b + " + (uint64_t)" + c + ");\n"; break;
+		case SUBX: source += "\t" + a + " = VMAN_WRAP64((uint64_t)" + b + " - (uint64_t)" + c + ");\n"; break;
+		case MULX: source += "\t" + a + " = VMAN_WRAP64((uint64_t)" + b + " * (uint64_t)" + c + ");\n"; break;
+		case DIVX: divide(NATIVE_WIDE_DIVISION_BY_ZERO, "VMAN_WRAP64(0u - (uint64_t)" + b + ")", " / "); break;
+		case MODX: divide(NATIVE_WIDE_DIVISION_BY_ZERO, "0", " % "); break;
+		case LSHX: source += "\t" + a + " = VMAN_WRAP64((uint64_t)" + b + " << (" + c + " & 63));\n"; break;
+		case RSHX: source += "\t" + a + " = " + b + " >> (" + c + " & 63);\n"; break;
+		case NOTX: source += "\t" + a + " = ~" + b + ";\n"; break;
+		case ANDX: source += "\t" + a + " = " + b + " & " + c + ";\n"; break;
+		case ORX: source += "\t" + a + " = " + b + " | " + c + ";\n"; break;
+		case XORX: source += "\t" + a + " = " + b + " ^ " + c + ";\n"; break;
+		case MOVX: source += "\t" + a + " = (int64_t)" + Hex64(program.constants[ins.imm]) + ";\n"; break;
+
+		case ADDF: source += "\t" + a + " = " + b + " + " + c + ";\n"; break;
+		case SUBF: source += "\t" + a + " = " + b + " - " + c + ";\n"; break;
+		case DIVF: source += "\t" + a + " = " + b + " / " + c + ";\n"; break;
+		case MULF: source += "\t" + a + " = " + b + " * " + c + ";\n"; break;
+		case MOVF: source += "\t" + a + " = vman_bits(" + Hex64(program.constants[ins.imm]) + ");\n"; break;
+
+		case CMPX:
+		case CMPF: source += "\t" + a + " = VMAN_COMPARE(" + b + ", " + c + ");\n"; break;
+
+		case SEXT: source += "\t" + a + " = " + b + ";\n"; break;
+		case TRUNC: source += "\t" + a + " = (int32_t)" + b + ";\n"; break;
+		case ITOF: source += "\t" + a + " = (double)" + b + ";\n"; break;
+		case FTOI: source += "\t" + a + " = vman_truncate(" + b + ");\n"; break;
+
+		/*
+		 * The vector instructions run in the kernels of the host, which pick the instruction set of the CPU.
+		**/
+		case VADD:
+		case VMUL:
+		case VMIN:
+		case VMAX:
+		case VCMP:
+		case VMASK:
+		case VADDF:
+		case VMULF:
+		case VMINF:
+		case VMAXF:
+		case VDOT:
+		case VDOTF:
+		{
+			const std::string index = std::to_string(&ins - program.code.data()) + "u";
+			const std::string first = ins.opcode == VDOTF ? "0" : a;
+			source += "\t{\n";
+			source += "\t\tconst int32_t values[4] = { " + first + ", " + b + ", " + c + ", r" + std::to_string(ins.imm) + " };\n";
+
+			if (ins.opcode == VDOT) source += "\t\t" + a + " = (int32_t)host->vector(host->context, " + index + ", values).integer;\n";
+			else if (ins.opcode == VDOTF) source += "\t\t" + a + " = host->vector(host->context, " + index + ", values).real;\n";
+			else source += "\t\thost->vector(host->context, " + index + ", values);\n";
+			source += "\t}\n";
+		} break;
+
+		case LOAD8: source += "\tVMAN_LOAD(" + a + ", uint8_t, " + b + ");\n"; break;
+		case LOAD8S: source += "\tVMAN_LOAD(" + a + ", int8_t, " + b + ");\n"; break;
+		case LOAD16: source += "\tVMAN_LOAD(" + a + ", uint16_t, " + b + ");\n"; break;
+		case LOAD16S: source += "\tVMAN_LOAD(" + a + ", int16_t, " + b + ");\n"; break;
+		case LOAD32: source += "\tVMAN_LOAD(" + a + ", int32_t, " + b + ");\n"; break;
+		case LOADX: source += "\tVMAN_LOAD(" + a + ", int64_t, " + b + ");\n"; break;
+		case LOADF: source += "\tVMAN_LOAD(" + a + ", double, " + b + ");\n"; break;
+		case STORE8: source += "\tVMAN_STORE(uint8_t, " + a + ", " + b + ");\n"; break;
+		case STORE16: source += "\tVMAN_STORE(uint16_t, " + a + ", " + b + ");\n"; break;
+		case STORE32: source += "\tVMAN_STORE(int32_t, " + a + ", " + b + ");\n"; break;
+		case STOREX: source += "\tVMAN_STORE(int64_t, " + a + ", " + b + ");\n"; break;
+		case STOREF: source += "\tVMAN_STORE(double, " + a + ", " + b + ");\n"; break;
+
+		/*
+		 * The host checks the ranges of the bulk operations against the size of the memory, which the module doesn't know.
+		**/
+		case MEMCPY:
+		case MEMSET:
+		case MEMCMP:
+		{
+			const std::string index = std::to_string(&ins - program.code.data()) + "u";
+			const std::string values = ins.opcode == MEMCMP ? "0, " + b + ", " + c + ", r" + std::to_string(ins.imm) : a + ", " + b + ", " + c + ", 0";
+			source += "\t{\n";
+			source += "\t\tconst int32_t values[4] = { " + values + " };\n";
+
+			if (ins.opcode == MEMCMP) source += "\t\t" + a + " = (int32_t)host->vector(host->context, " + index + ", values).integer;\n";
+			else source += "\t\thost->vector(host->context, " + index + ", values);\n";
+			source += "\t}\n";
+		} break;
+
+		case JMP: source += "\t" + jump(ins.a) + "\n"; break;
+
+		case JIE:
+		case JNE:
+			source += "\tif (" + a + (ins.opcode == JIE ? " == " : " != ") + b + ") " + jump(ins.c) + "\n";
+			break;
+
+		case NFC:
+		case NFCI:
+			EmitNativeCall(program, ins);
+			break;
+
+		case HALT:
+			source += "\tVMAN_SPILL();\n\treturn 0;\n";
+			break;
+
+		default:
+			source += "\t;\n";
+			break;
+	}
+}
+
+void Translator::EmitDispatch(const Program& program)
+{
+	source += "dispatch:\n";
+	source += "\tswitch ((uint32_t)target)\n";
+	source += "\t{\n";
+	for (u32 i = 0; i < program.code.size(); ++i)
+	{
+		source += "\t\tcase " + std::to_string(program.code[i].address) + "u: goto " + Label(i) + ";\n";
+	}
+	source += "\t\tdefault: VMAN_RAISE(" + std::to_string(NATIVE_INVALID_JUMP) + ", targetRegister, target);\n";
+	source += "\t}\n";
+}
+
+void Translator::Translate(const Program& program, const Image& fileBytes)
+{
+	source.clear();
+	EmitPrologue(fileBytes);
+
+	bool dispatch = false;
+	const std::vector<bool> labels = Labels(program, dispatch);
+
+	source += "VMAN_EXPORT int32_t vman_run(int32_t* registers, int64_t* wide, double* floats, char* image, const struct vman_host* host)\n{\n";
+	for (const Bank& bank : BANKS)
+	{
+		for (std::size_t i = 0; i < REGISTER_COUNT; ++i)
+		{
+			source += i % 6 == 0 ? "\t" + std::string(bank.type) + " " : ", ";
+			source += bank.prefix + std::to_string(i) + " = " + bank.array + "[" + std::to_string(i) + "]";
+			if (i % 6 == 5) source += ";\n";
+		}
+	}
+	if (dispatch) source += "\tint32_t target = 0, targetRegister = 0;\n";
+	source += "\tchar* const memory = host->memory;\n";
+	source += "\t(void)image;\n";
+	source += "\t(void)memory;\n\n";
+	source += "\tgoto " + Label(program.entry) + ";\n\n";
+
+	/*
+	 * The instructions follow each other in the same order as in the binary, so every instruction falls through to the next one.
+	**/
+	for (u32 i = 0; i < program.code.size(); ++i)
+	{
+		if (labels[i]) source += Label(i) + ":\n";
+		EmitInstruction(program, program.code[i]);
+	}
+
+	if (dispatch)
+	{
+		source += '\n';
+		EmitDispatch(program);
+	}
+	source += "}\n";
+}
+
+bool Translator::TranslateFile(const std::string& input, const std::string& output)
+{
+	Image fileBytes;
+	if (!fileBytes.Map(input)) return false;
+
+	/*
+	 * The program gets decoded and verified exactly like the interpreter does it while loading,
+	 * so the call sites and resolved jumps match the ones of the executable that runs the compiled module.
+	**/
+	ImageLayout layout;
+	Program program;
+	if (!ReadLayout(fileBytes, layout) || !program.Decode(fileBytes, layout) || !Verify(program, fileBytes)) return false;
+
+	if (fileBytes.size() > INT32_MAX)
+	{
+		std::cerr << "[ERROR] The binary is too large to be compiled.\n";
+		return false;
+	}
+
+	Translate(program, fileBytes);
+
+	std::ofstream file(output, std::ios::binary | std::ios::trunc);
+	if (!file.write(source.data(), static_cast<std::streamsize>(source.size())))
+	{
+		std::cerr << "[ERROR] Failed to write file.\n";
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <string>
+
+#include "../core/types.hpp"
+#include "../core/image.hpp"
+#include "../core/decoder.hpp"
+
+namespace vman::aot
+{
+	/*
+	 * Translates a binary ahead of time into a C source file. Every instruction becomes a few lines of C that work
+	 * on local variables, jumps whose target the verifier resolved become a goto, the remaining ones go through
+	 * a switch over every instruction address. The source embeds the image, compiled into a shared library
+	 * it is loaded by "vman -e" in place of the binary:
+	 *
+	 *     vman -c program.bin program.c
+	 *     cc -O2 -shared -fPIC program.c -o program.so
+	 *     vman -e program.so
+	 *
+	 * Native calls with a signature that has a trampoline are called directly from C, every other call,
+	 * the lookup of NFC and every error go back to virtual man through the host structure of native.hpp.
+	**/
+	class Translator
+	{
+	private:
+		std::string source;
+
+		void EmitPrologue(const core::Image&);
+		void EmitInstruction(const core::Program&, const core::Instruction&);
+		void EmitNativeCall(const core::Program&, const core::Instruction&);
+		void EmitDispatch(const core::Program&);
+
+	public:
+		/*
+		 * Translates a decoded and verified program, the image has to be the one it has been decoded from.
+		**/
+		void Translate(const core::Program&, const core::Image&);
+
+		/*
+		 * Loads a binary, translates it and writes the C source to the output file.
+		 * Returns false if the binary isn't compatible or the file can't be written.
+		**/
+		bool TranslateFile(const std::string& input, const std::string& output);
+
+		const std::string& Source(void) const noexcept { return source; }
+	};
+};
\ No newline at end of file
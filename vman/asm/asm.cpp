@@ -19,4 +19,758 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  *
-**/
\ No newline at end of file
+**/
+
+#include "asm.hpp"
+
+#include <array>
+#include <limits>
+#include <cstring>
+#include <cstdlib>
+#include <type_traits>
+
+using vasm::Assembler;
+
+using namespace vman;
+using namespace vman::core;
+using vmb::Bridge;
+
+namespace
+{
+	constexpr std::size_t EncodableCount(void) noexcept
+	{
+		std::size_t count = 0;
+		for (const OpcodeInfo& info : OPCODES) count += info.encodable ? 1 : 0;
+		return count;
+	}
+
+	/*
+	 * The opcodes a mnemonic can name, taken from the opcode table so the assembler knows every instruction the decoder does.
+	**/
+	constexpr const std::array<u8, EncodableCount()> ENCODABLE = []
+	{
+		std::array<u8, EncodableCount()> list = {};
+		std::size_t count = 0;
+		for (std::size_t opcode = 0; opcode < OPCODES.size(); ++opcode)
+		{
+			if (OPCODES[opcode].encodable) list[count++] = static_cast<u8>(opcode);
+		}
+		return list;
+	}();
+
+	// Type codes start at 1, 0 terminates the parameter list of NFC.
+	constexpr const int MAX_TYPE = Bridge::VMBVOID;
+
+	/*
+	 * The most operands a line can have, .import has a name, the library, the function, the return type
+	 * and up to MAX_NFC_PARAMS parameter types.
+	**/
+	constexpr const std::size_t MAX_OPERANDS = MAX_NFC_PARAMS + 4;
+
+	bool IsSpace(char c) noexcept { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+	bool IsIdentifier(char c) noexcept { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'; }
+
+	std::string_view Trim(std::string_view text) noexcept
+	{
+		while (!text.empty() && IsSpace(text.front())) text.remove_prefix(1);
+		while (!text.empty() && IsSpace(text.back())) text.remove_suffix(1);
+		return text;
+	}
+
+	bool EqualsIgnoreCase(std::string_view a, std::string_view b) noexcept
+	{
+		if (a.size() != b.size()) return false;
+		for (std::size_t i = 0; i < a.size(); ++i)
+		{
+			char c = a[i];
+			if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+			if (c != b[i]) return false;
+		}
+		return true;
+	}
+
+	/*
+	 * Splits the operands at every comma outside of quotes, returns the number of operands or MAX_OPERANDS + 1 if there are too many.
+	**/
+	std::size_t Split(std::string_view text, std::array<std::string_view, MAX_OPERANDS>& operands) noexcept
+	{
+		if (text.empty()) return 0;
+
+		std::size_t count = 0;
+		std::size_t start = 0;
+		char quote = 0;
+
+		for (std::size_t i = 0; i <= text.size(); ++i)
+		{
+			const char c = i < text.size() ? text[i] : ',';
+			if (quote != 0)
+			{
+				if (c == '\\') ++i;
+				else if (c == quote) quote = 0;
+			}
+			else if (c == '"' || c == '\'') quote = c;
+			else if (c == ',')
+			{
+				if (count == MAX_OPERANDS) return MAX_OPERANDS + 1;
+				operands[count++] = Trim(text.substr(start, i - start));
+				start = i + 1;
+			}
+		}
+		return count;
+	}
+
+	// Translates the character after a backslash, returns -1 for unknown escape sequences.
+	int Escape(char c) noexcept
+	{
+		switch (c)
+		{
+			case 'n': return '\n';
+			case 't': return '\t';
+			case 'r': return '\r';
+			case '0': return '\0';
+			case '\\': return '\\';
+			case '"': return '"';
+			case '\'': return '\'';
+			default: return -1;
+		}
+	}
+
+	template<class T>
+	void Append(std::vector<char>& out, T value)
+	{
+		char bytes[sizeof(T)];
+		memcpy(bytes, &value, sizeof(T));
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+};
+
+void Assembler::Error(const std::string& message)
+{
+	std::cerr << "[ERROR] Line " << line << ": " << message << "\n";
+	++errors;
+}
+
+bool Assembler::Register(std::string_view operand, u8& reg, char bank)
+{
+	// A register is written with the prefix of its bank, r, x or f, or as a plain number.
+	std::string_view digits = operand;
+	if (!digits.empty() && (digits[0] == bank || digits[0] == bank - 'a' + 'A')) digits.remove_prefix(1);
+
+	unsigned value = 0;
+	for (char c : digits)
+	{
+		if (c < '0' || c > '9' || value >= REGISTER_COUNT)
+		{
+			value = REGISTER_COUNT;
+			break;
+		}
+		value = value * 10 + static_cast<unsigned>(c - '0');
+	}
+
+	if (digits.empty() || value >= REGISTER_COUNT)
+	{
+		Error("Invalid register \"" + std::string(operand) + "\".");
+		return false;
+	}
+
+	reg = static_cast<u8>(value);
+	return true;
+}
+
+bool Assembler::Number(std::string_view operand, s64& value)
+{
+	std::string_view text = operand;
+	const bool negative = !text.empty() && text[0] == '-';
+	if (!text.empty() && (text[0] == '-' || text[0] == '+')) text.remove_prefix(1);
+
+	u64 result = 0;
+	bool valid = !text.empty();
+
+	if (text.size() >= 3 && text.front() == '\'' && text.back() == '\'')
+	{
+		// Character literals, either a single character or an escape sequence.
+		if (text.size() == 3) result = static_cast<u8>(text[1]);
+		else if (text.size() == 4 && text[1] == '\\' && Escape(text[2]) >= 0) result = static_cast<u64>(Escape(text[2]));
+		else valid = false;
+	}
+	else
+	{
+		unsigned base = 10;
+		if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) base = 16;
+		else if (text.size() > 2 && text[0] == '0' && (text[1] == 'b' || text[1] == 'B')) base = 2;
+		if (base != 10) text.remove_prefix(2);
+
+		for (char c : text)
+		{
+			unsigned digit;
+			if (c >= '0' && c <= '9') digit = static_cast<unsigned>(c - '0');
+			else if (c >= 'a' && c <= 'f') digit = static_cast<unsigned>(c - 'a' + 10);
+			else if (c >= 'A' && c <= 'F') digit = static_cast<unsigned>(c - 'A' + 10);
+			else digit = base;
+
+			// Values that don't even fit into 64 bits are rejected here, the callers check their own range.
+			if (digit >= base || result > (UINT64_MAX - digit) / base)
+			{
+				valid = false;
+				break;
+			}
+			result = result * base + digit;
+		}
+	}
+
+	if (!valid)
+	{
+		Error("Invalid number \"" + std::string(operand) + "\".");
+		return false;
+	}
+
+	value = static_cast<s64>(negative ? 0 - result : result);
+	return true;
+}
+
+bool Assembler::Type(std::string_view operand, u8& type, bool parameter)
+{
+	// "reg <type>" passes the parameter from its x or f register instead of the binary.
+	int flags = 0;
+	if (operand.size() > 4 && EqualsIgnoreCase(operand.substr(0, 3), "reg") && IsSpace(operand[3]))
+	{
+		flags = Bridge::VMBREGISTER;
+		operand = Trim(operand.substr(4));
+	}
+
+	int value = EqualsIgnoreCase(operand, "pointer") ? Bridge::VMBPOINTER : 0;
+	for (int candidate = 1; candidate <= MAX_TYPE && value == 0; ++candidate)
+	{
+		if (EqualsIgnoreCase(operand, Bridge::TypeName(candidate))) value = candidate;
+	}
+
+	if (value == 0)
+	{
+		Error("Unknown type \"" + std::string(operand) + "\".");
+		return false;
+	}
+
+	if (parameter && value == Bridge::VMBVOID)
+	{
+		Error("void is only allowed as return type.");
+		return false;
+	}
+
+	if (flags != 0 && (!parameter || value == Bridge::VMBPOINTER))
+	{
+		Error("Only parameters of a number type can be passed in registers.");
+		return false;
+	}
+
+	type = static_cast<u8>(value | flags);
+	return true;
+}
+
+bool Assembler::String(std::string_view operand, std::string& value)
+{
+	if (operand.size() < 2 || operand.front() != '"' || operand.back() != '"')
+	{
+		Error("Expected a string in quotes.");
+		return false;
+	}
+
+	value.clear();
+	for (std::size_t i = 1; i + 1 < operand.size(); ++i)
+	{
+		if (operand[i] != '\\')
+		{
+			value.push_back(operand[i]);
+			continue;
+		}
+
+		const int escaped = i + 2 < operand.size() ? Escape(operand[i + 1]) : -1;
+		if (escaped < 0)
+		{
+			Error("Invalid escape sequence in string.");
+			return false;
+		}
+		value.push_back(static_cast<char>(escaped));
+		++i;
+	}
+	return true;
+}
+
+void Assembler::Directive(std::string_view name, std::string_view operands)
+{
+	if (name == ".data" || name == ".code" || name == ".text")
+	{
+		if (!operands.empty()) Error(std::string(name) + " doesn't take operands.");
+		inCode = name != ".data";
+		return;
+	}
+
+	if (inCode)
+	{
+		Error("Data directives are only allowed in the data section.");
+		return;
+	}
+
+	if (name == ".string")
+	{
+		std::string value;
+		if (!String(operands, value)) return;
+
+		data.insert(data.end(), value.begin(), value.end());
+		data.push_back('\0');
+		return;
+	}
+
+	std::array<std::string_view, MAX_OPERANDS> values;
+	std::size_t count = 0;
+
+	// Numbers are written in the byte order of the host, that is how the native functions read them.
+	auto integers = [&](auto type)
+	{
+		using T = decltype(type);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			s64 value;
+			if (!Number(values[i], value)) return;
+
+			using U = std::make_unsigned_t<T>;
+			if (sizeof(T) < sizeof(s64) && (value < static_cast<s64>(std::numeric_limits<T>::min()) || value > static_cast<s64>(std::numeric_limits<U>::max())))
+			{
+				Error("Value \"" + std::string(values[i]) + "\" doesn't fit into " + std::string(name) + ".");
+				return;
+			}
+			Append(data, static_cast<T>(value));
+		}
+	};
+
+	auto reals = [&](auto type)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const std::string text(values[i]);
+			char* end = nullptr;
+			const double value = strtod(text.c_str(), &end);
+			if (text.empty() || *end != '\0')
+			{
+				Error("Invalid floating point number \"" + text + "\".");
+				return;
+			}
+			Append(data, static_cast<decltype(type)>(value));
+		}
+	};
+
+	// Longer lists have to be split over several lines.
+	count = Split(operands, values);
+	if (count == 0 || count > MAX_OPERANDS)
+	{
+		Error(std::string(name) + " expects between 1 and " + std::to_string(MAX_OPERANDS) + " values.");
+		return;
+	}
+
+	if (name == ".import") Import(values.data(), count);
+	else if (name == ".byte") integers(s8());
+	else if (name == ".short") integers(s16());
+	else if (name == ".int") integers(s32());
+	else if (name == ".quad") integers(s64());
+	else if (name == ".float") reals(f32());
+	else if (name == ".double") reals(f64());
+	else if (name == ".zero")
+	{
+		s64 size;
+		if (count != 1 || !Number(values[0], size) || size < 0 || size > 0x10000000)
+		{
+			Error(".zero expects a size.");
+			return;
+		}
+		data.insert(data.end(), static_cast<std::size_t>(size), '\0');
+	}
+	else if (name == ".memory")
+	{
+		// The size of the linear memory in pages of 64 KiB.
+		s64 pages;
+		if (count != 1 || !Number(values[0], pages) || pages < 0 || pages > MAX_MEMORY_PAGES)
+		{
+			Error(".memory expects between 0 and " + std::to_string(MAX_MEMORY_PAGES) + " pages.");
+			return;
+		}
+		memoryPages = static_cast<u32>(pages);
+	}
+	else Error("Unknown directive \"" + std::string(name) + "\".");
+}
+
+void Assembler::Instruction(std::string_view name, std::string_view operandText)
+{
+	const OpcodeInfo* mnemonic = nullptr;
+	u8 opcode = NOP;
+	for (u8 candidate : ENCODABLE)
+	{
+		if (EqualsIgnoreCase(name, OPCODES[candidate].name))
+		{
+			mnemonic = &OPCODES[candidate];
+			opcode = candidate;
+			break;
+		}
+	}
+
+	if (mnemonic == nullptr)
+	{
+		Error("Unknown instruction \"" + std::string(name) + "\".");
+		return;
+	}
+
+	if (!inCode)
+	{
+		Error("Instructions are only allowed in the code section.");
+		return;
+	}
+
+	std::array<std::string_view, MAX_OPERANDS> operands;
+	const std::size_t count = Split(operandText, operands);
+
+	if (mnemonic->operands == Operands::Types)
+	{
+		if (count == 0 || count > MAX_NFC_PARAMS + 1)
+		{
+			Error("nfc expects a return type and up to " + std::to_string(MAX_NFC_PARAMS) + " parameter types.");
+			return;
+		}
+	}
+	else
+	{
+		const std::size_t expected = RegisterOperands(mnemonic->operands) +
+			(mnemonic->operands == Operands::RegisterImmediate || mnemonic->operands == Operands::RegisterWide || mnemonic->operands == Operands::Import ? 1 : 0);
+
+		if (count != expected)
+		{
+			Error(std::string(mnemonic->name) + " expects " + std::to_string(expected) + (expected == 1 ? " operand." : " operands."));
+			return;
+		}
+	}
+
+	u8 encoded[2 + MAX_OPERANDS + 8];
+	std::size_t length = 1;
+	encoded[0] = opcode;
+
+	switch (mnemonic->operands)
+	{
+		case Operands::None:
+			break;
+
+		case Operands::Register:
+		case Operands::TwoRegisters:
+		case Operands::ThreeRegisters:
+		case Operands::FourRegisters:
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (!Register(operands[i], encoded[length++], RegisterBank(*mnemonic, i))) return;
+			}
+			break;
+
+		case Operands::RegisterImmediate:
+		{
+			if (!Register(operands[0], encoded[1])) return;
+
+			const char first = operands[1].empty() ? '\0' : operands[1][0];
+			s64 value = 0;
+
+			if ((first >= '0' && first <= '9') || first == '-' || first == '+' || first == '\'')
+			{
+				if (!Number(operands[1], value)) return;
+				if (value < INT32_MIN || value > UINT32_MAX)
+				{
+					Error("Value \"" + std::string(operands[1]) + "\" doesn't fit into 32 bits.");
+					return;
+				}
+			}
+			else
+			{
+				for (char c : operands[1])
+				{
+					if (!IsIdentifier(c))
+					{
+						Error("Invalid operand \"" + std::string(operands[1]) + "\".");
+						return;
+					}
+				}
+				fixups.push_back({ static_cast<u32>(code.size() + 2), operands[1], line });
+			}
+
+			// The immediate of MOV is big endian encoded
+			const u32 bits = static_cast<u32>(value);
+			encoded[2] = static_cast<u8>(bits >> 24);
+			encoded[3] = static_cast<u8>(bits >> 16);
+			encoded[4] = static_cast<u8>(bits >> 8);
+			encoded[5] = static_cast<u8>(bits >> 0);
+			length = 6;
+		} break;
+
+		case Operands::RegisterWide:
+		{
+			if (!Register(operands[0], encoded[1], RegisterBank(*mnemonic, 0))) return;
+
+			u64 bits = 0;
+			if (opcode == MOVF)
+			{
+				// MOVF takes a floating point number, its bits are stored as the immediate.
+				const std::string text(operands[1]);
+				char* end = nullptr;
+				const double value = strtod(text.c_str(), &end);
+				if (text.empty() || *end != '\0')
+				{
+					Error("Invalid floating point number \"" + text + "\".");
+					return;
+				}
+				memcpy(&bits, &value, sizeof(bits));
+			}
+			else
+			{
+				s64 value = 0;
+				if (!Number(operands[1], value)) return;
+				bits = static_cast<u64>(value);
+			}
+
+			// The immediate of MOVX and MOVF is big endian encoded as well
+			for (int i = 0; i < 8; ++i) encoded[2 + i] = static_cast<u8>(bits >> (56 - i * 8));
+			length = 10;
+		} break;
+
+		case Operands::Types:
+			// The return type is followed by the zero terminated list of parameter types.
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (!Type(operands[i], encoded[length++], i != 0)) return;
+			}
+			encoded[length++] = 0;
+			break;
+
+		case Operands::Import:
+		{
+			// Imports have to be declared before they are called.
+			auto it = importIndices.find(operands[0]);
+			if (it == importIndices.end())
+			{
+				Error("Unknown import \"" + std::string(operands[0]) + "\".");
+				return;
+			}
+
+			// The import index of NFCI is big endian encoded
+			encoded[1] = static_cast<u8>(it->second >> 8);
+			encoded[2] = static_cast<u8>(it->second >> 0);
+			length = 3;
+		} break;
+	}
+
+	lines.push_back({ static_cast<u32>(code.size()), static_cast<u32>(line) });
+	code.insert(code.end(), encoded, encoded + length);
+}
+
+void Assembler::Import(const std::string_view* operands, std::size_t count)
+{
+	if (count < 4)
+	{
+		Error(".import expects a name, the library, the function, the return type and the parameter types.");
+		return;
+	}
+
+	const std::string_view name = operands[0];
+	for (char c : name)
+	{
+		if (!IsIdentifier(c))
+		{
+			Error("Invalid import name \"" + std::string(name) + "\".");
+			return;
+		}
+	}
+
+	if (importIndices.count(name) != 0 || imports.size() > UINT16_MAX)
+	{
+		Error(importIndices.count(name) != 0 ? "Import \"" + std::string(name) + "\" is already defined." : std::string("Too many imports."));
+		return;
+	}
+
+	ImportEntry entry = {};
+	entry.paramCount = static_cast<u8>(count - 4);
+	if (!Type(operands[3], entry.returnType, false)) return;
+	for (std::size_t i = 0; i < entry.paramCount; ++i)
+	{
+		if (!Type(operands[4 + i], entry.paramTypes[i], true)) return;
+	}
+
+	// The names go into the data section like any other string.
+	std::string library;
+	std::string function;
+	if (!String(operands[1], library) || !String(operands[2], function)) return;
+
+	entry.library = static_cast<u32>(data.size());
+	data.insert(data.end(), library.begin(), library.end());
+	data.push_back('\0');
+	entry.function = static_cast<u32>(data.size());
+	data.insert(data.end(), function.begin(), function.end());
+	data.push_back('\0');
+
+	importIndices.emplace(name, static_cast<u16>(imports.size()));
+	imports.push_back(entry);
+}
+
+void Assembler::Line(std::string_view text)
+{
+	// Comments end the line, unless they are part of a string or character.
+	char quote = 0;
+	for (std::size_t i = 0; i < text.size(); ++i)
+	{
+		const char c = text[i];
+		if (quote != 0)
+		{
+			if (c == '\\') ++i;
+			else if (c == quote) quote = 0;
+		}
+		else if (c == '"' || c == '\'') quote = c;
+		else if (c == ';' || c == '#')
+		{
+			text = text.substr(0, i);
+			break;
+		}
+	}
+
+	text = Trim(text);
+
+	std::size_t identifier = 0;
+	while (identifier < text.size() && IsIdentifier(text[identifier])) ++identifier;
+
+	if (identifier != 0 && identifier < text.size() && text[identifier] == ':')
+	{
+		const std::string_view name = text.substr(0, identifier);
+		const Label label = { inCode, static_cast<u32>(inCode ? code.size() : data.size()) };
+
+		if (!labels.emplace(name, label).second) Error("Label \"" + std::string(name) + "\" is already defined.");
+		text = Trim(text.substr(identifier + 1));
+	}
+
+	if (text.empty()) return;
+
+	std::size_t nameLength = 0;
+	while (nameLength < text.size() && !IsSpace(text[nameLength])) ++nameLength;
+
+	const std::string_view name = text.substr(0, nameLength);
+	const std::string_view operands = Trim(text.substr(nameLength));
+
+	if (name[0] == '.') Directive(name, operands);
+	else Instruction(name, operands);
+}
+
+bool Assembler::Assemble(std::string_view source)
+{
+	data.clear();
+	code.clear();
+	binary.clear();
+	labels.clear();
+	fixups.clear();
+	lines.clear();
+	imports.clear();
+	importIndices.clear();
+	memoryPages = 0;
+	inCode = true;
+	line = 0;
+	errors = 0;
+
+	while (!source.empty())
+	{
+		++line;
+		const std::size_t end = source.find('\n');
+		Line(source.substr(0, end));
+		source.remove_prefix(end == std::string_view::npos ? source.size() : end + 1);
+	}
+
+	/*
+	 * The code section comes last, so the addresses of code labels are only known once all data has been read.
+	 * Every label a MOV loads gets a relocation entry, every instruction an entry with its source line.
+	**/
+	const u16 sectionCount = memoryPages != 0 ? 6 : 5;
+	const u32 dataStart = static_cast<u32>(SECTIONED_HEADER_SIZE + sectionCount * SECTION_ENTRY_SIZE);
+	const u32 importStart = dataStart + static_cast<u32>(data.size());
+	const u32 relocationStart = importStart + static_cast<u32>(imports.size() * IMPORT_ENTRY_SIZE);
+	const u32 debugStart = relocationStart + static_cast<u32>(fixups.size() * sizeof(u32));
+	const u32 memoryStart = debugStart + static_cast<u32>(lines.size() * 2 * sizeof(u32));
+	const u32 codeStart = memoryStart + (memoryPages != 0 ? static_cast<u32>(sizeof(u32)) : 0);
+
+	for (const Fixup& fixup : fixups)
+	{
+		line = fixup.line;
+
+		auto it = labels.find(fixup.label);
+		if (it == labels.end())
+		{
+			Error("Unknown label \"" + std::string(fixup.label) + "\".");
+			continue;
+		}
+
+		const u32 address = (it->second.code ? codeStart : dataStart) + it->second.offset;
+		code[fixup.offset + 0] = static_cast<char>(address >> 24);
+		code[fixup.offset + 1] = static_cast<char>(address >> 16);
+		code[fixup.offset + 2] = static_cast<char>(address >> 8);
+		code[fixup.offset + 3] = static_cast<char>(address >> 0);
+	}
+
+	if (errors != 0)
+	{
+		std::cerr << "[ERROR] Assembling failed with " << errors << (errors == 1 ? " error.\n" : " errors.\n");
+		return false;
+	}
+
+	const u64 entry = codeStart;
+
+	binary.reserve(codeStart + code.size());
+	Append(binary, entry);
+	Append(binary, SIGNATURE);
+	Append(binary, SECTION_MAGIC);
+	Append(binary, IMAGE_VERSION);
+	Append(binary, sectionCount);
+
+	const auto section = [this](SectionType type, u32 offset, std::size_t size)
+	{
+		Append(binary, static_cast<u32>(type));
+		Append(binary, offset);
+		Append(binary, static_cast<u32>(size));
+		Append(binary, u32(0));
+	};
+	section(SectionType::Data, dataStart, data.size());
+	section(SectionType::Imports, importStart, relocationStart - importStart);
+	section(SectionType::Relocations, relocationStart, debugStart - relocationStart);
+	section(SectionType::Debug, debugStart, memoryStart - debugStart);
+	if (memoryPages != 0) section(SectionType::Memory, memoryStart, sizeof(u32));
+	section(SectionType::Code, codeStart, code.size());
+
+	binary.insert(binary.end(), data.begin(), data.end());
+	for (const ImportEntry& import : imports)
+	{
+		Append(binary, dataStart + import.library);
+		Append(binary, dataStart + import.function);
+		binary.push_back(static_cast<char>(import.returnType));
+		binary.push_back(static_cast<char>(import.paramCount));
+		binary.insert(binary.end(), import.paramTypes, import.paramTypes + MAX_NFC_PARAMS);
+	}
+	for (const Fixup& fixup : fixups) Append(binary, codeStart + fixup.offset);
+	for (const DebugLine& debugLine : lines)
+	{
+		Append(binary, codeStart + debugLine.offset);
+		Append(binary, debugLine.line);
+	}
+	if (memoryPages != 0) Append(binary, memoryPages);
+	binary.insert(binary.end(), code.begin(), code.end());
+	return true;
+}
+
+bool Assembler::AssembleFile(const std::string& source, const std::string& output)
+{
+	Image image;
+	if (!image.Map(source)) return false;
+
+	if (!Assemble(std::string_view(image.data(), image.size()))) return false;
+
+	std::ofstream file(output, std::ios::binary | std::ios::trunc);
+	if (!file.write(binary.data(), static_cast<std::streamsize>(binary.size())))
+	{
+		std::cerr << "[ERROR] Failed to write file.\n";
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
@@ -26,18 +26,127 @@
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <unordered_map>
+#include <iostream>
+
+#include "../core/types.hpp"
+#include "../core/opcodes.hpp"
+#include "../core/image.hpp"
+#include "../core/decoder.hpp"
+#include "../vmb/vmb.hpp"
 
 
 namespace vasm
 {
+	/*
+	 * Translates VirtualMAN assembly into a binary in a single pass over the source.
+	 * Data and code are collected separately, the binary consists of the header, the section table, the data section,
+	 * the relocations, the source lines, the size of the linear memory if .memory asks for it and the code section,
+	 * the entry point is the first instruction of the code section.
+	 * Labels that are used before they are defined get patched once the whole source has been read.
+	 *
+	 *         .data
+	 * lib:    .string "ucrtbase"
+	 * func:   .string "puts"
+	 * text:   .string "Hello"
+	 *
+	 *         .code
+	 *         mov r0, lib         ; labels are loaded as addresses
+	 *         mov r1, func
+	 *         mov r2, text
+	 *         nfc int, ptr        ; return type followed by the parameter types
+	 *
+	 * Native functions can be imported instead, they are resolved while the binary is loaded:
+	 *
+	 *         .data
+	 *         .import print, "ucrtbase", "puts", int, ptr
+	 *
+	 *         .code
+	 *         mov r2, text
+	 *         nfci print
+	 *
+	 * Registers are written as r0 to r11 or as plain numbers, immediates as decimal, hexadecimal (0x) or character ('a') values.
+	 * The data section knows .string, .byte, .short, .int, .quad, .float, .double, .zero and .import,
+	 * comments start with ';' or '#'.
+	**/
 	class Assembler
 	{
 	private:
+		struct Label
+		{
+			bool code;
+			vman::u32 offset;
+		};
+
+		// A MOV whose immediate is the address of a label.
+		struct Fixup
+		{
+			vman::u32 offset;
+			std::string_view label;
+			std::size_t line;
+		};
+
+		// The source line of an instruction, they end up in the debug section.
+		struct DebugLine
+		{
+			vman::u32 offset;
+			vman::u32 line;
+		};
+
+		// An import declared through .import, the names are offsets into the data section.
+		struct ImportEntry
+		{
+			vman::u32 library;
+			vman::u32 function;
+			vman::u8 returnType;
+			vman::u8 paramCount;
+			vman::u8 paramTypes[vman::core::MAX_NFC_PARAMS];
+		};
+
+		std::vector<char> data;
+		std::vector<char> code;
+		std::vector<char> binary;
+
+		std::unordered_map<std::string_view, Label> labels;
+		std::vector<Fixup> fixups;
+		std::vector<DebugLine> lines;
+		std::vector<ImportEntry> imports;
+		std::unordered_map<std::string_view, vman::u16> importIndices;
+
+		// Pages of linear memory requested through .memory, the binary only gets a memory section if it isn't 0.
+		vman::u32 memoryPages = 0;
+
+		bool inCode = true;
+		std::size_t line = 0;
+		std::size_t errors = 0;
+
+		void Error(const std::string& message);
+
+		void Line(std::string_view text);
+		void Directive(std::string_view name, std::string_view operands);
+		void Instruction(std::string_view mnemonic, std::string_view operands);
+		void Import(const std::string_view* operands, std::size_t count);
 
+		bool Register(std::string_view operand, vman::u8& reg, char bank = 'r');
+		bool Number(std::string_view operand, vman::s64& value);
+		bool Type(std::string_view operand, vman::u8& type, bool parameter);
+		bool String(std::string_view operand, std::string& value);
 
 	public:
+		/*
+		 * Assembles a whole source text, errors are printed with their line and counted.
+		 * The string_view has to stay valid until Assemble returns. Returns false if the source contains errors.
+		**/
+		bool Assemble(std::string_view source);
 
+		// The binary of the last successful Assemble.
+		const std::vector<char>& Binary(void) const noexcept { return binary; }
 
+		/*
+		 * Maps the source file, assembles it and writes the binary to the output file.
+		**/
+		bool AssembleFile(const std::string& source, const std::string& output);
 	};
 }
\ No newline at end of file
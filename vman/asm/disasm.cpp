@@ -12,265 +12,404 @@ using vmb::Bridge;
  * for my IT apprenticeship, can change in the future.
 **/
 
-Disassembler::Disassembler(const std::string& path)
+namespace
 {
-	LoadLibrary("User32.dll");
-	std::fstream fStream(path, std::ios::binary | std::ios::in);
-	if (fStream.is_open())
+	/*
+	 * The code section is formatted in chunks of about this many bytes, every chunk goes into its own buffer.
+	**/
+	constexpr const std::size_t CHUNK_SIZE = 64 * 1024;
+
+	struct Palette
 	{
-		std::uintmax_t size = std::filesystem::file_size(path);
-		fileBytes.resize(size);
-		if (fileBytes.size() != size)
+		const char* address;
+		const char* operand;
+		const char* reset;
+	};
+
+	constexpr const Palette COLORED = { "\033[1;31m", "\033[1;33m", "\033[0m" };
+	constexpr const Palette PLAIN = { "", "", "" };
+
+	void Hex(std::string& out, u64 value)
+	{
+		char digits[16];
+		int count = 0;
+		do
 		{
-			std::cerr << "[ERROR] Failed to allocate memory.\n";
-			return;
-		}
+			digits[count++] = "0123456789abcdef"[value & 0xF];
+			value >>= 4;
+		} while (value != 0);
 
-		fStream.read(fileBytes.data(), size);
+		out += "0x";
+		while (count > 0) out += digits[--count];
+	}
 
-		if (!fStream)
+	void Decimal(std::string& out, unsigned value)
+	{
+		char digits[10];
+		int count = 0;
+		do
 		{
-			std::cerr << "[ERROR] Failed to read file.\n";
-			return;
-		}
-		fStream.close();
-		return;
+			digits[count++] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		} while (value != 0);
+
+		while (count > 0) out += digits[--count];
 	}
-	else std::cerr << "[ERROR] Failed to open file.\n";
-	return;
-}
 
-void Disassembler::Disassemble(void) const
-{
-	std::size_t i;
-	std::size_t vmSignature;
+	// Appends the name of a type, types that are passed in registers get the "reg" prefix of the assembler.
+	void TypeName(std::string& out, u8 type)
+	{
+		if (type & Bridge::VMBREGISTER) out += "reg ";
 
-	memcpy(&i, &fileBytes[0], sizeof(std::size_t));
-	memcpy(&vmSignature, &fileBytes[8], sizeof(std::size_t));
+		const std::string_view name = Bridge::TypeName(type & ~Bridge::VMBREGISTER);
+		if (!name.empty()) out += name;
+		else Hex(out, type);
+	}
+
+	// Appends the zero terminated name at the address, without reading past the end of the image.
+	void Name(std::string& out, const Image& image, std::size_t address)
+	{
+		for (std::size_t i = address; i < image.size() && image[i] != '\0'; ++i) out += image[i];
+	}
 
 	/*
-	 * Virtual man checks here if the given binary file has the 1911 KUQEZI (described in the project documentation)
-	 * signature, if virtual man can't detect this signature, it will refuse to disassemble or execute the binary.
+	 * Finds the entry of a sorted table inside the image whose first 32 bit value equals the key, returns its offset or 0.
 	**/
-	if (vmSignature != 0x495A4551554B1119)
+	std::size_t Find(const Image& image, const Section& table, std::size_t stride, std::size_t key) noexcept
 	{
-		std::cerr << "[ERROR] This is not a compatible virtual man binary.\n";
-		return;
+		std::size_t low = 0;
+		std::size_t high = table.size / stride;
+		while (low < high)
+		{
+			const std::size_t middle = low + (high - low) / 2;
+			const std::size_t entry = table.offset + middle * stride;
+			const u32 value = image.ReadU32(entry);
+
+			if (value == key) return entry;
+			if (value < key) low = middle + 1;
+			else high = middle;
+		}
+		return 0;
 	}
+};
 
-	std::cout << "\n[INFO] Analyzing loaded libraries...\n\n";
+Disassembler::Disassembler(const std::string& path)
+	: color(vmb::platform::OutputIsTerminal())
+{
+	vmb::platform::LoadModule("User32.dll");
+	fileBytes.Map(path);
+}
 
-	HMODULE hMods[1024];
-	DWORD cbNeeded;
-	HANDLE hProc;
-	DWORD pid = GetCurrentProcessId();
+std::size_t Disassembler::FormatInstruction(std::size_t address, std::string& out) const
+{
+	const Palette& palette = color ? COLORED : PLAIN;
+	const u8* bytes = reinterpret_cast<const u8*>(fileBytes.data()) + address;
+	const std::size_t available = layout.code.end() - address;
+	const std::size_t length = InstructionLength(bytes, available, layout.version == 1);
+	const OpcodeInfo& info = OPCODES[Decoded(bytes[0])];
+
+	out += palette.address;
+	Hex(out, address);
+	out += palette.reset;
+	out += ": ";
+
+	if (length > available)
+	{
+		out += "(truncated)\n";
+		return available;
+	}
 
-	std::cout << "[INFO] VirtualMAN instance PID: \033[1;31m" << pid << "\033[0m\n\n";
+	out += info.name;
 
-	hProc = OpenProcess
-	(
-		PROCESS_QUERY_INFORMATION | PROCESS_VM_READ,
-		FALSE, 
-		pid
-	);
+	for (std::size_t i = 1; i <= RegisterOperands(info.operands); ++i)
+	{
+		out += i == 1 ? " " : ", ";
+		out += palette.operand;
+		out += RegisterBank(info, i - 1);
+		Decimal(out, bytes[i]);
+		out += palette.reset;
+	}
 
-	if (hProc == nullptr)
+	if (info.operands == Operands::RegisterImmediate)
 	{
-		std::cerr << "[ERROR] Failed to retrieve process id.\n";
-		return;
+		out += ", ";
+		out += palette.operand;
+		Hex(out, static_cast<u32>(Immediate(bytes)));
+		out += palette.reset;
 	}
+	else if (info.operands == Operands::RegisterWide)
+	{
+		out += ", ";
+		out += palette.operand;
+
+		const u64 bits = WideImmediate(bytes);
+		if (Decoded(bytes[0]) == MOVF)
+		{
+			// Printed with enough digits to assemble back into the same bits.
+			f64 value;
+			memcpy(&value, &bits, sizeof(value));
+
+			char text[32];
+			snprintf(text, sizeof(text), "%.17g", value);
+			out += text;
+		}
+		else Hex(out, bits);
 
-	if (EnumProcessModules(hProc, hMods, sizeof(hMods), &cbNeeded))
+		out += palette.reset;
+	}
+	else if (info.operands == Operands::Import)
 	{
-		for (int j = 0; j < (cbNeeded / sizeof(HMODULE)); ++j)
+		const u16 index = ImportIndex(bytes);
+		out += ' ';
+		out += palette.operand;
+		Decimal(out, index);
+		out += palette.reset;
+
+		if (index < layout.imports.size / IMPORT_ENTRY_SIZE)
 		{
-			TCHAR szModName[MAX_PATH];
-			if (GetModuleBaseNameA(hProc, hMods[j], szModName, sizeof(szModName) / sizeof(TCHAR)))
-			{
-				std::cout << "[\033[1;33mRESOLVED LIBRARY\033[0m] " << szModName << " (\033[1;31m0x" << hMods[j] << "\033[0m)\n";
-			}
+			const std::size_t entry = layout.imports.offset + index * IMPORT_ENTRY_SIZE;
+			out += " (";
+			Name(out, fileBytes, fileBytes.ReadU32(entry + 4));
+			out += " from ";
+			Name(out, fileBytes, fileBytes.ReadU32(entry));
+			out += ')';
+		}
+	}
+	else if (info.operands == Operands::Types)
+	{
+		// The return type is followed by the parameter types, the list ends at the terminating zero, which isn't listed.
+		for (std::size_t i = 1; i < length && (i == 1 || bytes[i]); ++i)
+		{
+			out += i == 1 ? " " : ", ";
+			out += palette.operand;
+			TypeName(out, bytes[i]);
+			out += palette.reset;
 		}
 	}
 
-	std::cout << "\n";
-	CloseHandle(hProc);
+	FormatComment(address, bytes, out);
+	out += '\n';
+	return length;
+}
 
-	std::cout << "[INFO] Entry point starts at \033[1;31m0x" << std::hex << i << "\033[0m\n";
-	std::cout << "[INFO] Corresponding VirtualMAN signature detected: 777 \033[41m\033[1;30mKUQ E ZI!\033[0m\n";
-	std::cout << "[INFO] Data section has a size of \033[1;31m0x" << std::hex << i - 1 << "\033[0m\n";
+void Disassembler::FormatComment(std::size_t address, const u8* bytes, std::string& out) const
+{
+	const std::size_t debugLine = Find(fileBytes, layout.debug, 8, address);
+	const bool relocated = OPCODES[Decoded(bytes[0])].operands == Operands::RegisterImmediate && Find(fileBytes, layout.relocations, 4, address + 2) != 0;
+	if (debugLine == 0 && !relocated) return;
 
-	std::cout << "\n[INFO] Analyzing data section...\n\n";
+	out += " ;";
+	if (debugLine != 0)
+	{
+		out += " line ";
+		Decimal(out, fileBytes.ReadU32(debugLine + 4));
+	}
 
-	for (size_t j = 0x10; j < i; j++)
+	if (relocated)
 	{
-		if (fileBytes[j] >= 0x21 && fileBytes[j] <= 0x7E)
+		/*
+		 * The immediate is an address, strings of the data section are shown like in the data listing.
+		**/
+		const u32 target = static_cast<u32>(Immediate(bytes));
+		if (target >= layout.code.offset && target <= layout.code.end()) out += " -> code";
+		else if (target >= layout.data.offset && target < layout.data.end() && fileBytes[target] >= 0x20 && fileBytes[target] <= 0x7E)
 		{
-			std::cout << "\033[1;31m0x" << std::hex << j << "\033[0m: ";
-			std::cout << "\033[1;33m";
-			while (fileBytes[j])
+			out += " \"";
+			for (std::size_t i = target; i < layout.data.end() && i < target + 32 && fileBytes[i] >= 0x20 && fileBytes[i] <= 0x7E; ++i)
 			{
-				std::cout << fileBytes[j];
-				j++;
+				out += fileBytes[i];
 			}
-			std::cout << "\n";
+			out += '"';
 		}
 	}
+}
+
+void Disassembler::FormatRange(std::size_t begin, std::size_t end, std::string& out) const
+{
+	for (std::size_t address = begin; address < end; )
+	{
+		address += FormatInstruction(address, out);
+	}
+}
+
+void Disassembler::FormatHeader(std::string& out) const
+{
+	const Palette& palette = color ? COLORED : PLAIN;
+
+	out += "\n[INFO] Analyzing loaded libraries...\n\n";
+
+	out += "[INFO] VirtualMAN instance PID: ";
+	out += palette.address;
+	Decimal(out, static_cast<unsigned>(vmb::platform::ProcessId()));
+	out += palette.reset;
+	out += "\n\n";
+
+	for (const vmb::platform::Module& module : vmb::platform::LoadedModules())
+	{
+		out += color ? "[\033[1;33mRESOLVED LIBRARY\033[0m] " : "[RESOLVED LIBRARY] ";
+		out += module.name;
+		out += " (";
+		out += palette.address;
+		Hex(out, reinterpret_cast<std::uintptr_t>(module.base));
+		out += palette.reset;
+		out += ")\n";
+	}
 
-	std::cout << "\n\033[0m[INFO] \033[0mAnalyzing opcodes...\n\n";
+	out += "\n[INFO] Entry point starts at ";
+	out += palette.address;
+	Hex(out, layout.entry);
+	out += palette.reset;
+	out += color ? "\n[INFO] Corresponding VirtualMAN signature detected: 777 \033[41m\033[1;30mKUQ E ZI!\033[0m\n"
+		: "\n[INFO] Corresponding VirtualMAN signature detected: 777 KUQ E ZI!\n";
 
-	for (; i < fileBytes.size(); i++)
+	if (layout.version > 1)
 	{
-		switch (fileBytes[i])
+		out += "[INFO] Binary version ";
+		Decimal(out, layout.version);
+		out += " with a section table\n";
+
+		const std::pair<const char*, const Section*> sections[] =
 		{
-			case MOV:
-			{
-				s32 movValue;
-
-				// Directly converts a big endian encoded byte array
-				movValue = ((fileBytes[i + 6] << 0) | (fileBytes[i + 5] << 8) | (fileBytes[i + 4] << 16) | (fileBytes[i + 3] << 24)) / 0x100;
-				
-				std::cout 
-					<< "\033[1;31m0x" 
-					<< std::hex << i 
-					<< "\033[0m: mov \033[1;33mr" 
-					<< static_cast<int>(fileBytes[i + 1]) 
-					<< "\033[0m, " 
-					<< std::hex 
-					<< "\033[1;33m0x" 
-					<< movValue 
-					<< "\n";
-				i += 5;
-			} break;
-
-			case NFC:
-			{
-				std::cout << "\033[1;31m0x" << std::hex << i << "\033[0m: " << "nfc ";
-				std::cout << "\033[1;33m";
-				while (fileBytes[i])
-				{
-					++i;
-
-					switch (fileBytes[i])
-					{
-					case Bridge::VMBBOOL: std::cout << "bool"; break;
-					case Bridge::VMBCHAR: std::cout << "char"; break;
-					case Bridge::VMBSHORT: std::cout << "short"; break;
-					case Bridge::VMBINT: std::cout << "int"; break;
-					case Bridge::VMBLONG: std::cout << "long"; break;
-					case Bridge::VMBLONG_LONG: std::cout << "long long"; break;
-					case Bridge::VMBFLOAT: std::cout << "float"; break;
-					case Bridge::VMBDOUBLE: std::cout << "double"; break;
-					case Bridge::VMBPOINTER: std::cout << "ptr"; break;
-					}
-
-					if (fileBytes[i + 1] != '\0')
-					{
-						std::cout << "\033[0m, \033[1;33m";
-					}
-				}
-				
-				std::cout << "\n";
-			} break;
-
-			case ADD:
-			{
-				std::cout << "add " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-			}
-			break;
+			{ "Code", &layout.code }, { "Data", &layout.data }, { "Imports", &layout.imports },
+			{ "Relocations", &layout.relocations }, { "Debug", &layout.debug }, { "Memory", &layout.memory },
+		};
+		for (const auto& [name, section] : sections)
+		{
+			if (section->empty()) continue;
+
+			out += "[INFO] ";
+			out += name;
+			out += " section at ";
+			out += palette.address;
+			Hex(out, section->offset);
+			out += palette.reset;
+			out += ", size ";
+			out += palette.address;
+			Hex(out, section->size);
+			out += palette.reset;
+			out += '\n';
+		}
 
-			case SUB:
-			{
-				std::cout << "sub " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-			}
-			break;
+		if (layout.memoryPages != 0)
+		{
+			out += "[INFO] Linear memory of ";
+			Decimal(out, layout.memoryPages);
+			out += layout.memoryPages == 1 ? " page\n" : " pages\n";
+		}
+	}
 
-			case DIV:
-			{
-				std::cout << "div " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-			}
-			break;
+	out += "[INFO] Data section has a size of ";
+	out += palette.address;
+	Hex(out, layout.data.size);
+	out += palette.reset;
+	out += "\n\n[INFO] Analyzing data section...\n\n";
 
-			case MUL:
-			{
-				std::cout << "mul " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-			}
-			break;
+	/*
+	 * The data section has no structure, every run of printable characters is listed as a string.
+	**/
+	const std::size_t end = layout.data.end();
+	for (std::size_t j = layout.data.offset; j < end; j++)
+	{
+		if (fileBytes[j] < 0x21 || fileBytes[j] > 0x7E) continue;
+
+		out += palette.address;
+		Hex(out, j);
+		out += palette.reset;
+		out += ": ";
+		out += palette.operand;
+		while (j < end && fileBytes[j])
+		{
+			out += fileBytes[j];
+			j++;
+		}
+		out += palette.reset;
+		out += '\n';
+	}
 
-			case MOD:
-			{
-				std::cout << "mod " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-			}
-			break;
+	if (!layout.imports.empty())
+	{
+		out += "\n[INFO] Analyzing imports...\n\n";
 
-			case LSH:
+		for (std::size_t entry = layout.imports.offset; entry < layout.imports.end(); entry += IMPORT_ENTRY_SIZE)
+		{
+			out += palette.address;
+			Decimal(out, static_cast<unsigned>((entry - layout.imports.offset) / IMPORT_ENTRY_SIZE));
+			out += palette.reset;
+			out += ": ";
+			out += palette.operand;
+			Name(out, fileBytes, fileBytes.ReadU32(entry + 4));
+			out += palette.reset;
+			out += " from ";
+			Name(out, fileBytes, fileBytes.ReadU32(entry));
+			out += ", ";
+			TypeName(out, static_cast<u8>(fileBytes[entry + 8]));
+			out += '(';
+
+			const u8 paramCount = static_cast<u8>(fileBytes[entry + 9]);
+			for (u8 i = 0; i < paramCount && i < MAX_NFC_PARAMS; ++i)
 			{
-				std::cout << "lsh " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
+				if (i != 0) out += ", ";
+				TypeName(out, static_cast<u8>(fileBytes[entry + 10 + i]));
 			}
-			break;
+			out += ")\n";
+		}
+	}
 
-			case RSH:
-			{
-				std::cout << "rsh " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-			}
-			break;
+	out += "\n[INFO] Analyzing opcodes...\n\n";
+}
 
-			case AND:
-			{
-				std::cout << "and " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-			}
-			break;
+void Disassembler::Disassemble(void)
+{
+	/*
+	 * Virtual man checks here if the given binary file has the 1911 KUQEZI (described in the project documentation)
+	 * signature, if virtual man can't detect this signature, it will refuse to disassemble or execute the binary.
+	**/
+	if (!ReadLayout(fileBytes, layout)) return;
 
-			case OR:
-			{
-				std::cout << "or " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-			}
-			break;
+	std::string header;
+	FormatHeader(header);
+	std::cout.write(header.data(), static_cast<std::streamsize>(header.size()));
 
-			case XOR:
-			{
-				std::cout << "xor " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-			}
-			break;
+	/*
+	 * The boundaries of the chunks have to fall between two instructions, so the lengths are scanned up front.
+	 * That is cheap compared to the formatting, which is what runs on the pool.
+	**/
+	const u8* bytes = reinterpret_cast<const u8*>(fileBytes.data());
+	const std::size_t size = layout.code.end();
 
-			case NOT:
-			{
-				std::cout << "not " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-			}
-			break;
+	std::unique_ptr<ThreadPool> pool;
+	if (threads > 1) pool = std::make_unique<ThreadPool>(threads);
 
-			case JMP:
-				std::cout << "jmp " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 2;
-				break;
+	std::vector<std::string> buffers(threads);
+	std::vector<std::pair<std::size_t, std::size_t>> chunks(threads);
+	std::vector<std::future<void>> formatted;
 
-			case JIE:
-				std::cout << "jie " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-				break;
+	for (std::size_t address = layout.code.offset; address < size; )
+	{
+		std::size_t count = 0;
+		for (; count < threads && address < size; ++count)
+		{
+			chunks[count].first = address;
+			const std::size_t limit = std::min(size, address + CHUNK_SIZE);
+			while (address < limit) address += InstructionLength(bytes + address, size - address, layout.version == 1);
+			chunks[count].second = address = std::min(address, size);
+		}
 
-			case JNE:
-				std::cout << "jie " << static_cast<int>(fileBytes[i + 1]) << ", " << static_cast<int>(fileBytes[i + 2]) << ", " << static_cast<int>(fileBytes[i + 3]);
-				i += 3;
-				break;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			buffers[i].clear();
+			if (pool == nullptr) FormatRange(chunks[i].first, chunks[i].second, buffers[i]);
+			else formatted.push_back(pool->Submit([this, &chunks, &buffers, i] { FormatRange(chunks[i].first, chunks[i].second, buffers[i]); }));
+		}
 
-			case NOP:
-			default:
-			{
-				std::cout << "\033[1;31m0x" << std::hex << i << "\033[0m: " << "nop\n";
-			} break;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (pool != nullptr) formatted[i].get();
+			std::cout.write(buffers[i].data(), static_cast<std::streamsize>(buffers[i].size()));
 		}
+		formatted.clear();
 	}
-	
-	std::cout << "\033[0m";
+
+	if (color) std::cout << "\033[0m";
+	std::cout.flush();
 }
\ No newline at end of file
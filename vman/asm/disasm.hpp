@@ -3,24 +3,56 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <cstring>
+#include <cstdio>
 #include <iostream>
 #include <filesystem>
 
 #include "../core/types.hpp"
 #include "../core/opcodes.hpp"
+#include "../core/image.hpp"
+#include "../core/pool.hpp"
 #include "../vmb/vmb.hpp"
 
 
 namespace vasm
 {
+	/*
+	 * Lists the data section and the instructions of a binary. Every line is formatted into a buffer,
+	 * which is written in one piece, the code section is processed in chunks, so the output
+	 * of an image of any size only needs a few buffers. The chunks can be formatted on several threads,
+	 * they are still written in order.
+	**/
 	class Disassembler
 	{
 	private:
-		std::vector<char> fileBytes;
+		vman::core::Image fileBytes;
+		vman::core::ImageLayout layout;
+
+		// ANSI colours are only written to a terminal, unless they are turned on or off explicitly.
+		bool color;
+		std::size_t threads = 1;
+
+		/*
+		 * Formats the instructions that start between begin and end into out, the last one may reach past end.
+		**/
+		void FormatRange(std::size_t begin, std::size_t end, std::string& out) const;
+
+		// Formats the instruction at the address and returns its length.
+		std::size_t FormatInstruction(std::size_t address, std::string& out) const;
+
+		// Appends the source line and the target of a relocated immediate, if the binary has them.
+		void FormatComment(std::size_t address, const vman::u8* bytes, std::string& out) const;
+
+		void FormatHeader(std::string& out) const;
 
 	public:
 
 		Disassembler(const std::string&);
-		void Disassemble(void) const;
+
+		void SetColor(bool enable) noexcept { color = enable; }
+		void SetThreads(std::size_t count) noexcept { threads = count == 0 ? 1 : count; }
+
+		void Disassemble(void);
 	};
 }
\ No newline at end of file
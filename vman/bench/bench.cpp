@@ -0,0 +1,973 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "bench.hpp"
+
+#if defined (__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+using vman::bench::ProgramWriter;
+
+using namespace vman;
+using namespace vman::core;
+
+ProgramWriter::ProgramWriter(void)
+	: bytes(SECTIONED_HEADER_SIZE + SECTIONS * SECTION_ENTRY_SIZE, 0)
+{
+	memcpy(&bytes[8], &SIGNATURE, sizeof(SIGNATURE));
+	memcpy(&bytes[0x10], &SECTION_MAGIC, sizeof(SECTION_MAGIC));
+	memcpy(&bytes[0x14], &IMAGE_VERSION, sizeof(IMAGE_VERSION));
+
+	memcpy(&bytes[0x16], &SECTIONS, sizeof(SECTIONS));
+}
+
+void ProgramWriter::Entry(void)
+{
+	const u64 PC = bytes.size();
+	memcpy(&bytes[0], &PC, sizeof(PC));
+}
+
+u32 ProgramWriter::String(const std::string& value)
+{
+	const u32 address = Here();
+	bytes.insert(bytes.end(), value.begin(), value.end());
+	bytes.push_back('\0');
+	return address;
+}
+
+u32 ProgramWriter::Zero(std::size_t size)
+{
+	const u32 address = Here();
+	bytes.insert(bytes.end(), size, 0);
+	return address;
+}
+
+u32 ProgramWriter::Mov(u8 reg, s32 value)
+{
+	const u32 address = Here();
+	bytes.push_back(static_cast<char>(MOV));
+	bytes.push_back(static_cast<char>(reg));
+	bytes.insert(bytes.end(), 4, 0);
+	Patch(address, value);
+	return address;
+}
+
+void ProgramWriter::Patch(u32 movAddress, s32 value)
+{
+	// The immediate of MOV is big endian encoded
+	const u32 bits = static_cast<u32>(value);
+	bytes[movAddress + 2] = static_cast<char>(bits >> 24);
+	bytes[movAddress + 3] = static_cast<char>(bits >> 16);
+	bytes[movAddress + 4] = static_cast<char>(bits >> 8);
+	bytes[movAddress + 5] = static_cast<char>(bits >> 0);
+}
+
+void ProgramWriter::Op(u8 opcode, u8 a, u8 b, u8 c)
+{
+	bytes.push_back(static_cast<char>(opcode));
+	bytes.push_back(static_cast<char>(a));
+	bytes.push_back(static_cast<char>(b));
+	bytes.push_back(static_cast<char>(c));
+}
+
+void ProgramWriter::Not(u8 a, u8 b)
+{
+	bytes.push_back(static_cast<char>(NOT));
+	bytes.push_back(static_cast<char>(a));
+	bytes.push_back(static_cast<char>(b));
+}
+
+void ProgramWriter::Vector(u8 opcode, u8 destination, u8 a, u8 b, u8 count)
+{
+	bytes.push_back(static_cast<char>(opcode));
+	bytes.push_back(static_cast<char>(destination));
+	bytes.push_back(static_cast<char>(a));
+	bytes.push_back(static_cast<char>(b));
+	bytes.push_back(static_cast<char>(count));
+}
+
+void ProgramWriter::Access(u8 opcode, u8 a, u8 b)
+{
+	bytes.push_back(static_cast<char>(opcode));
+	bytes.push_back(static_cast<char>(a));
+	bytes.push_back(static_cast<char>(b));
+}
+
+void ProgramWriter::Jmp(u8 reg)
+{
+	bytes.push_back(static_cast<char>(JMP));
+	bytes.push_back(static_cast<char>(reg));
+}
+
+void ProgramWriter::Nfc(u8 returnType, const std::vector<u8>& paramTypes)
+{
+	bytes.push_back(static_cast<char>(NFC));
+	bytes.push_back(static_cast<char>(returnType));
+	bytes.insert(bytes.end(), paramTypes.begin(), paramTypes.end());
+	bytes.push_back('\0');
+}
+
+u16 ProgramWriter::Import(u32 library, u32 function, u8 returnType, const std::vector<u8>& paramTypes)
+{
+	imports.push_back({ library, function, returnType, paramTypes });
+	return static_cast<u16>(imports.size() - 1);
+}
+
+void ProgramWriter::Nfci(u16 index)
+{
+	// The import index of NFCI is big endian encoded
+	bytes.push_back(static_cast<char>(NFCI));
+	bytes.push_back(static_cast<char>(index >> 8));
+	bytes.push_back(static_cast<char>(index >> 0));
+}
+
+std::vector<char> ProgramWriter::Finish(void) const
+{
+	std::vector<char> image = bytes;
+
+	u64 entry;
+	memcpy(&entry, &image[0], sizeof(entry));
+
+	const u32 tableEnd = static_cast<u32>(SECTIONED_HEADER_SIZE + SECTIONS * SECTION_ENTRY_SIZE);
+	const u32 codeEnd = static_cast<u32>(image.size());
+	const u32 importsEnd = codeEnd + static_cast<u32>(imports.size() * IMPORT_ENTRY_SIZE);
+	const u32 sections[SECTIONS][3] =
+	{
+		{ static_cast<u32>(SectionType::Data), tableEnd, static_cast<u32>(entry) - tableEnd },
+		{ static_cast<u32>(SectionType::Code), static_cast<u32>(entry), codeEnd - static_cast<u32>(entry) },
+		{ static_cast<u32>(SectionType::Imports), codeEnd, importsEnd - codeEnd },
+		{ static_cast<u32>(SectionType::Memory), importsEnd, static_cast<u32>(sizeof(memoryPages)) },
+	};
+	for (std::size_t i = 0; i < SECTIONS; ++i)
+	{
+		memcpy(&image[SECTIONED_HEADER_SIZE + i * SECTION_ENTRY_SIZE], sections[i], sizeof(sections[i]));
+	}
+
+	for (const ImportEntry& import : imports)
+	{
+		char entryBytes[IMPORT_ENTRY_SIZE] = {};
+		memcpy(&entryBytes[0], &import.library, sizeof(u32));
+		memcpy(&entryBytes[4], &import.function, sizeof(u32));
+		entryBytes[8] = static_cast<char>(import.returnType);
+		entryBytes[9] = static_cast<char>(import.paramTypes.size());
+		memcpy(&entryBytes[10], import.paramTypes.data(), import.paramTypes.size());
+		image.insert(image.end(), entryBytes, entryBytes + IMPORT_ENTRY_SIZE);
+	}
+
+	const char* pages = reinterpret_cast<const char*>(&memoryPages);
+	image.insert(image.end(), pages, pages + sizeof(memoryPages));
+	return image;
+}
+
+namespace
+{
+	/*
+	 * A loop with a data dependent branch in its body:
+	 *
+	 * loop: and r5, r0, r3
+	 *       jie r5, r4, r7     ; every fourth iteration jumps to skip
+	 *       add r6, r6, r1
+	 *       jmp r8
+	 * skip: sub r6, r6, r1
+	 * join: add r0, r0, r1
+	 *       jne r0, r2, r9
+	**/
+	std::vector<char> BranchyLoop(s32 iterations)
+	{
+		ProgramWriter writer;
+		writer.Entry();
+
+		writer.Mov(0, 0);
+		writer.Mov(1, 1);
+		writer.Mov(2, iterations);
+		writer.Mov(3, 3);
+		writer.Mov(4, 0);
+		writer.Mov(6, 0);
+		const u32 skip = writer.Mov(7, 0);
+		const u32 join = writer.Mov(8, 0);
+		const u32 loop = writer.Mov(9, 0);
+
+		writer.Patch(loop, writer.Here());
+		writer.Op(AND, 5, 0, 3);
+		writer.Op(JIE, 5, 4, 7);
+		writer.Op(ADD, 6, 6, 1);
+		writer.Jmp(8);
+		writer.Patch(skip, writer.Here());
+		writer.Op(SUB, 6, 6, 1);
+		writer.Patch(join, writer.Here());
+		writer.Op(ADD, 0, 0, 1);
+		writer.Op(JNE, 0, 2, 9);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * A straight arithmetic loop, nearly every instruction reads two registers and writes one:
+	 *
+	 * loop: add r3, r3, r1
+	 *       xor r4, r4, r3
+	 *       sub r5, r4, r3
+	 *       and r6, r5, r4
+	 *       or  r7, r6, r3
+	 *       mul r8, r7, r1
+	 *       add r0, r0, r1
+	 *       jne r0, r2, r9
+	**/
+	std::vector<char> ArithmeticLoop(s32 iterations)
+	{
+		ProgramWriter writer;
+		writer.Entry();
+
+		writer.Mov(0, 0);
+		writer.Mov(1, 1);
+		writer.Mov(2, iterations);
+		const u32 loop = writer.Mov(9, 0);
+
+		writer.Patch(loop, writer.Here());
+		writer.Op(ADD, 3, 3, 1);
+		writer.Op(XOR, 4, 4, 3);
+		writer.Op(SUB, 5, 4, 3);
+		writer.Op(AND, 6, 5, 4);
+		writer.Op(OR, 7, 6, 3);
+		writer.Op(MUL, 8, 7, 1);
+		writer.Op(ADD, 0, 0, 1);
+		writer.Op(JNE, 0, 2, 9);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * A loop that mostly loads immediates, consecutive MOVs get fused into superinstructions:
+	 *
+	 * loop: mov r3, 1
+	 *       mov r4, 2
+	 *       mov r5, 3
+	 *       mov r6, 4
+	 *       mov r7, 5
+	 *       mov r8, 6
+	 *       add r0, r0, r1
+	 *       jne r0, r2, r9
+	**/
+	std::vector<char> MovLoop(s32 iterations)
+	{
+		ProgramWriter writer;
+		writer.Entry();
+
+		writer.Mov(0, 0);
+		writer.Mov(1, 1);
+		writer.Mov(2, iterations);
+		const u32 loop = writer.Mov(9, 0);
+
+		writer.Patch(loop, writer.Here());
+		for (u8 reg = 3; reg <= 8; ++reg)
+		{
+			writer.Mov(reg, reg - 2);
+		}
+		writer.Op(ADD, 0, 0, 1);
+		writer.Op(JNE, 0, 2, 9);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * A loop over two buffers of elements in the data section, the vector opcodes do all of the work:
+	 *
+	 * loop: vadd r5, r3, r4, r6
+	 *       vmul r5, r5, r4, r6
+	 *       add  r0, r0, r1
+	 *       jne  r0, r2, r9
+	**/
+	std::vector<char> VectorLoop(s32 iterations, s32 elements)
+	{
+		ProgramWriter writer;
+		const u32 a = writer.Zero(elements * sizeof(s32));
+		const u32 b = writer.Zero(elements * sizeof(s32));
+		const u32 c = writer.Zero(elements * sizeof(s32));
+		writer.Entry();
+
+		writer.Mov(0, 0);
+		writer.Mov(1, 1);
+		writer.Mov(2, iterations);
+		writer.Mov(3, static_cast<s32>(a));
+		writer.Mov(4, static_cast<s32>(b));
+		writer.Mov(5, static_cast<s32>(c));
+		writer.Mov(6, elements);
+		const u32 loop = writer.Mov(9, 0);
+
+		writer.Patch(loop, writer.Here());
+		writer.Vector(VADD, 5, 3, 4, 6);
+		writer.Vector(VMUL, 5, 5, 4, 6);
+		writer.Op(ADD, 0, 0, 1);
+		writer.Op(JNE, 0, 2, 9);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * The same work as VectorLoop one element at a time, with three buffers of the same size in linear memory.
+	 * r3 is the offset of the element, it wraps around at the end of the buffers, so elements has to be a power of two:
+	 *
+	 * loop: load32  r6, r3
+	 *       add     r7, r3, r4
+	 *       load32  r8, r7
+	 *       add     r6, r6, r8
+	 *       mul     r6, r6, r8
+	 *       add     r7, r3, r5
+	 *       store32 r7, r6
+	 *       add     r3, r3, r10
+	 *       and     r3, r3, r11
+	 *       add     r0, r0, r1
+	 *       jne     r0, r2, r9
+	**/
+	std::vector<char> ScalarVectorLoop(s32 iterations, s32 elements)
+	{
+		const u32 size = static_cast<u32>(elements) * sizeof(s32);
+
+		ProgramWriter writer;
+		writer.Memory((3 * size + MEMORY_PAGE_SIZE - 1) / MEMORY_PAGE_SIZE);
+		writer.Entry();
+
+		writer.Mov(0, 0);
+		writer.Mov(1, 1);
+		writer.Mov(2, iterations * elements);
+		writer.Mov(3, 0);
+		writer.Mov(4, static_cast<s32>(size));
+		writer.Mov(5, static_cast<s32>(2 * size));
+		writer.Mov(10, sizeof(s32));
+		writer.Mov(11, static_cast<s32>(size - 1));
+		const u32 loop = writer.Mov(9, 0);
+
+		writer.Patch(loop, writer.Here());
+		writer.Access(LOAD32, 6, 3);
+		writer.Op(ADD, 7, 3, 4);
+		writer.Access(LOAD32, 8, 7);
+		writer.Op(ADD, 6, 6, 8);
+		writer.Op(MUL, 6, 6, 8);
+		writer.Op(ADD, 7, 3, 5);
+		writer.Access(STORE32, 7, 6);
+		writer.Op(ADD, 3, 3, 10);
+		writer.Op(AND, 3, 3, 11);
+		writer.Op(ADD, 0, 0, 1);
+		writer.Op(JNE, 0, 2, 9);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * A loop that walks through a page of linear memory, it stores and loads a word on every iteration:
+	 *
+	 * loop: store32 r3, r0
+	 *       load32  r4, r3
+	 *       add     r3, r3, r5
+	 *       and     r3, r3, r6
+	 *       add     r0, r0, r1
+	 *       jne     r0, r2, r9
+	**/
+	std::vector<char> MemoryLoop(s32 iterations)
+	{
+		ProgramWriter writer;
+		writer.Memory(1);
+		writer.Entry();
+
+		writer.Mov(0, 0);
+		writer.Mov(1, 1);
+		writer.Mov(2, iterations);
+		writer.Mov(3, 0);
+		writer.Mov(5, 4);
+		writer.Mov(6, static_cast<s32>(MEMORY_PAGE_SIZE - 4));
+		const u32 loop = writer.Mov(9, 0);
+
+		writer.Patch(loop, writer.Here());
+		writer.Access(STORE32, 3, 0);
+		writer.Access(LOAD32, 4, 3);
+		writer.Op(ADD, 3, 3, 5);
+		writer.Op(AND, 3, 3, 6);
+		writer.Op(ADD, 0, 0, 1);
+		writer.Op(JNE, 0, 2, 9);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * Fills, copies and compares two buffers of linear memory with the bulk opcodes:
+	 *
+	 * loop: memset r3, r0, r6
+	 *       memcpy r4, r3, r6
+	 *       memcmp r5, r4, r3, r6
+	 *       add    r0, r0, r1
+	 *       jne    r0, r2, r9
+	**/
+	std::vector<char> BulkLoop(s32 iterations, u32 size)
+	{
+		ProgramWriter writer;
+		writer.Memory(2 * size / MEMORY_PAGE_SIZE);
+		writer.Entry();
+
+		writer.Mov(0, 0);
+		writer.Mov(1, 1);
+		writer.Mov(2, iterations);
+		writer.Mov(3, 0);
+		writer.Mov(4, static_cast<s32>(size));
+		writer.Mov(6, static_cast<s32>(size));
+		const u32 loop = writer.Mov(9, 0);
+
+		writer.Patch(loop, writer.Here());
+		writer.Op(MEMSET, 3, 0, 6);
+		writer.Op(MEMCPY, 4, 3, 6);
+		writer.Vector(MEMCMP, 5, 4, 3, 6);
+		writer.Op(ADD, 0, 0, 1);
+		writer.Op(JNE, 0, 2, 9);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * Copies the first half of the memory into the second one on every iteration:
+	 *
+	 * loop: memcpy r4, r3, r6
+	 *       add    r0, r0, r1
+	 *       jne    r0, r2, r9
+	**/
+	std::vector<char> CopyLoop(s32 iterations, u32 size)
+	{
+		ProgramWriter writer;
+		writer.Memory(2 * size / MEMORY_PAGE_SIZE);
+		writer.Entry();
+
+		writer.Mov(0, 0);
+		writer.Mov(1, 1);
+		writer.Mov(2, iterations);
+		writer.Mov(3, 0);
+		writer.Mov(4, static_cast<s32>(size));
+		writer.Mov(6, static_cast<s32>(size));
+		const u32 loop = writer.Mov(9, 0);
+
+		writer.Patch(loop, writer.Here());
+		writer.Op(MEMCPY, 4, 3, 6);
+		writer.Op(ADD, 0, 0, 1);
+		writer.Op(JNE, 0, 2, 9);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * The same copy as CopyLoop a word at a time, r0 counts the copied bytes and r3 wraps around at the end of the source:
+	 *
+	 * loop: load32  r5, r3
+	 *       add     r4, r3, r8
+	 *       store32 r4, r5
+	 *       add     r3, r3, r7
+	 *       and     r3, r3, r6
+	 *       add     r0, r0, r7
+	 *       jne     r0, r2, r9
+	**/
+	std::vector<char> WordCopyLoop(s32 bytes, u32 size)
+	{
+		ProgramWriter writer;
+		writer.Memory(2 * size / MEMORY_PAGE_SIZE);
+		writer.Entry();
+
+		writer.Mov(0, 0);
+		writer.Mov(2, bytes);
+		writer.Mov(3, 0);
+		writer.Mov(6, static_cast<s32>(size - 1));
+		writer.Mov(7, 4);
+		writer.Mov(8, static_cast<s32>(size));
+		const u32 loop = writer.Mov(9, 0);
+
+		writer.Patch(loop, writer.Here());
+		writer.Access(LOAD32, 5, 3);
+		writer.Op(ADD, 4, 3, 8);
+		writer.Access(STORE32, 4, 5);
+		writer.Op(ADD, 3, 3, 7);
+		writer.Op(AND, 3, 3, 6);
+		writer.Op(ADD, 0, 0, 7);
+		writer.Op(JNE, 0, 2, 9);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * The name of the C runtime library, the functions of the benchmark are resolved from it.
+	**/
+#if defined (_WIN32)
+	constexpr const char* const LIBC = "ucrtbase.dll";
+#elif defined (__APPLE__)
+	constexpr const char* const LIBC = "libSystem.B.dylib";
+#else
+	constexpr const char* const LIBC = "libc.so.6";
+#endif
+
+	/*
+	 * The same loop as NativeCallLoop, the function comes from the import table:
+	 *
+	 * loop: mov r2, text
+	 *       nfci strlen
+	 *       add r3, r3, r4
+	 *       jne r3, r5, r6
+	**/
+	std::vector<char> ImportCallLoop(s32 iterations)
+	{
+		ProgramWriter writer;
+		const u32 library = writer.String(LIBC);
+		const u32 function = writer.String("strlen");
+		const u32 text = writer.String("VirtualMAN");
+		const u16 strlen = writer.Import(library, function, vmb::Bridge::VMBLONG_LONG, { vmb::Bridge::VMBPOINTER });
+		writer.Entry();
+
+		writer.Mov(3, 0);
+		writer.Mov(4, 1);
+		writer.Mov(5, iterations);
+		const u32 loop = writer.Mov(6, 0);
+
+		writer.Patch(loop, writer.Here());
+		writer.Mov(2, static_cast<s32>(text));
+		writer.Nfci(strlen);
+		writer.Op(ADD, 3, 3, 4);
+		writer.Op(JNE, 3, 5, 6);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * A loop around a native call of strlen, the result of NFC overwrites r2, so the argument is loaded every time:
+	 *
+	 * loop: mov r2, text
+	 *       nfc long long (pointer)
+	 *       add r3, r3, r4
+	 *       jne r3, r5, r6
+	**/
+	std::vector<char> NativeCallLoop(s32 iterations)
+	{
+		ProgramWriter writer;
+		const u32 library = writer.String(LIBC);
+		const u32 function = writer.String("strlen");
+		const u32 text = writer.String("VirtualMAN");
+		writer.Entry();
+
+		writer.Mov(0, static_cast<s32>(library));
+		writer.Mov(1, static_cast<s32>(function));
+		writer.Mov(3, 0);
+		writer.Mov(4, 1);
+		writer.Mov(5, iterations);
+		const u32 loop = writer.Mov(6, 0);
+
+		writer.Patch(loop, writer.Here());
+		writer.Mov(2, static_cast<s32>(text));
+		writer.Nfc(vmb::Bridge::VMBLONG_LONG, { vmb::Bridge::VMBPOINTER });
+		writer.Op(ADD, 3, 3, 4);
+		writer.Op(JNE, 3, 5, 6);
+
+		return writer.Finish();
+	}
+
+	/*
+	 * Counts the loads and stores of the host CPU through the L1 data cache accesses, only available on Linux.
+	 * Virtual machines and restricted kernels often don't expose these counters, in that case Open fails.
+	**/
+	class MemoryCounters
+	{
+	private:
+		int loads = -1;
+		int stores = -1;
+
+#if defined (__linux__)
+		static int Open(std::uint64_t operation)
+		{
+			perf_event_attr attr = {};
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.size = sizeof(attr);
+			attr.config = PERF_COUNT_HW_CACHE_L1D | (operation << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+		}
+
+		static std::uint64_t Read(int fd)
+		{
+			std::uint64_t value = 0;
+			return read(fd, &value, sizeof(value)) == sizeof(value) ? value : 0;
+		}
+#endif
+
+	public:
+		bool Open(void)
+		{
+#if defined (__linux__)
+			loads = Open(PERF_COUNT_HW_CACHE_OP_READ);
+			stores = Open(PERF_COUNT_HW_CACHE_OP_WRITE);
+#endif
+			return loads >= 0 && stores >= 0;
+		}
+
+		~MemoryCounters(void)
+		{
+#if defined (__linux__)
+			if (loads >= 0) close(loads);
+			if (stores >= 0) close(stores);
+#endif
+		}
+
+		// Runs the function and returns the number of loads and stores it performed.
+		template<class F>
+		std::pair<std::uint64_t, std::uint64_t> Count(F function)
+		{
+#if defined (__linux__)
+			ioctl(loads, PERF_EVENT_IOC_RESET, 0);
+			ioctl(stores, PERF_EVENT_IOC_RESET, 0);
+			ioctl(loads, PERF_EVENT_IOC_ENABLE, 0);
+			ioctl(stores, PERF_EVENT_IOC_ENABLE, 0);
+			function();
+			ioctl(loads, PERF_EVENT_IOC_DISABLE, 0);
+			ioctl(stores, PERF_EVENT_IOC_DISABLE, 0);
+			return { Read(loads), Read(stores) };
+#else
+			function();
+			return { 0, 0 };
+#endif
+		}
+	};
+
+	/*
+	 * What a run of a program executes, counted through the profiler.
+	 * Fused superinstructions are a single dispatch but count as two instructions.
+	**/
+	struct Counts
+	{
+		std::uint64_t instructions = 0;
+		std::uint64_t dispatches = 0;
+		std::uint64_t nativeCalls = 0;
+	};
+
+	// Runs the program once without and once with superinstructions, the executable is left fused.
+	Counts Count(const std::shared_ptr<Executable>& executable)
+	{
+		Counts counts;
+		Instance instance(executable);
+		instance.SetProfiling(true);
+
+		executable->Fuse(false);
+		instance.Execute();
+		counts.instructions = instance.GetProfiler()->Dispatches();
+		counts.nativeCalls = instance.GetProfiler()->Count(NFC) + instance.GetProfiler()->Count(NFCI);
+
+		executable->Fuse(true);
+		instance.Execute();
+		counts.dispatches = instance.GetProfiler()->Dispatches();
+		return counts;
+	}
+
+	// Returns the fastest of all runs in nanoseconds.
+	double Measure(Instance& instance, int repetitions)
+	{
+		double best = 0.0;
+		for (int i = 0; i < repetitions; ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			instance.Execute();
+			const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+			if (i == 0 || elapsed.count() < best) best = elapsed.count();
+		}
+		return best;
+	}
+
+	struct Workload
+	{
+		const char* name;
+		std::vector<char> image;
+	};
+
+	struct Engine
+	{
+		const char* name;
+		Dispatch dispatch;
+	};
+
+	struct Result
+	{
+		const char* workload;
+		const char* engine;
+		Counts counts;
+		double nanoseconds;
+
+		// The JIT runs whole blocks, so only the interpreters have a meaningful number of dispatches.
+		bool dispatched;
+	};
+
+	// Writes a number or null, if the value can't be computed for this result.
+	void JsonNumber(std::ostream& out, bool valid, double value)
+	{
+		if (valid) out << value;
+		else out << "null";
+	}
+
+	void WriteJson(std::ostream& out, const std::vector<Result>& results)
+	{
+		out << std::fixed << std::setprecision(3);
+		out << "{\n\t\"version\": \"" << VERSION << "\",\n\t\"results\": [";
+
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			const Result& result = results[i];
+			out << (i == 0 ? "\n" : ",\n");
+			out << "\t\t{ \"workload\": \"" << result.workload << "\", \"engine\": \"" << result.engine << "\""
+				<< ", \"instructions\": " << result.counts.instructions
+				<< ", \"dispatches\": ";
+			if (result.dispatched) out << result.counts.dispatches;
+			else out << "null";
+			out << ", \"native_calls\": " << result.counts.nativeCalls
+				<< ", \"time_ns\": " << result.nanoseconds
+				<< ", \"instructions_per_second\": " << result.counts.instructions / (result.nanoseconds / 1e9)
+				<< ", \"ns_per_instruction\": " << result.nanoseconds / result.counts.instructions
+				<< ", \"ns_per_dispatch\": ";
+			JsonNumber(out, result.dispatched && result.counts.dispatches != 0, result.nanoseconds / result.counts.dispatches);
+			out << ", \"ns_per_native_call\": ";
+			JsonNumber(out, result.counts.nativeCalls != 0, result.nanoseconds / result.counts.nativeCalls);
+			out << " }";
+		}
+		out << "\n\t]\n}\n";
+	}
+};
+
+bool vman::bench::SuiteBenchmark(const Options& options)
+{
+	const Workload workloads[] =
+	{
+		{ "arithmetic", ArithmeticLoop(2000000) },
+		{ "branch", BranchyLoop(2000000) },
+		{ "mov", MovLoop(2000000) },
+		{ "nfc", NativeCallLoop(200000) },
+		{ "import", ImportCallLoop(200000) },
+		{ "vector", VectorLoop(20000, 1024) },
+		{ "memory", MemoryLoop(2000000) },
+		{ "bulk", BulkLoop(5000, 4 * MEMORY_PAGE_SIZE) },
+	};
+
+	std::vector<Engine> engines = { { "switch", Dispatch::Switch } };
+#if VMAN_THREADED_DISPATCH
+	engines.push_back({ "threaded", Dispatch::Threaded });
+#else
+	std::cout << "[BENCH] Threaded dispatch isn't available in this build.\n";
+#endif
+#if VMAN_JIT
+	engines.push_back({ "jit", Dispatch::Jit });
+#else
+	std::cout << "[BENCH] The JIT isn't available on this target.\n";
+#endif
+
+	std::vector<Result> results;
+	for (const Workload& workload : workloads)
+	{
+		if (std::string(workload.name).find(options.filter) == std::string::npos) continue;
+
+		std::shared_ptr<Executable> executable = Executable::Create(Image(std::vector<char>(workload.image)));
+		if (executable == nullptr) return false;
+
+		const Counts counts = Count(executable);
+
+		for (const Engine& engine : engines)
+		{
+			Instance instance(executable);
+			instance.SetDispatch(engine.dispatch);
+
+			const Result result = { workload.name, engine.name, counts, Measure(instance, options.repetitions), engine.dispatch != Dispatch::Jit };
+			results.push_back(result);
+
+			std::cout << "[BENCH] " << std::left << std::setw(11) << result.workload << std::setw(9) << result.engine << std::right
+				<< std::fixed << std::setprecision(2) << std::setw(9) << result.nanoseconds / 1e6 << " ms, "
+				<< std::setw(8) << counts.instructions / (result.nanoseconds / 1e3) << " M instructions/s";
+
+			if (result.dispatched) std::cout << ", " << result.nanoseconds / counts.dispatches << " ns per dispatch";
+			if (counts.nativeCalls != 0) std::cout << ", " << result.nanoseconds / counts.nativeCalls << " ns per native call";
+			std::cout << "\n" << std::defaultfloat << std::setprecision(6);
+		}
+	}
+
+	if (!options.jsonPath.empty())
+	{
+		std::ofstream json(options.jsonPath, std::ios::trunc);
+		if (!json)
+		{
+			std::cerr << "[ERROR] Failed to open file.\n";
+			return false;
+		}
+
+		WriteJson(json, results);
+		std::cout << "[BENCH] Results written to " << options.jsonPath << "\n";
+	}
+	return true;
+}
+
+void vman::bench::RegisterBenchmark(void)
+{
+	std::shared_ptr<Executable> executable = Executable::Create(Image(ArithmeticLoop(10000000)));
+	if (executable == nullptr) return;
+
+	const std::uint64_t instructions = Count(executable).instructions;
+	std::cout << "[BENCH] Registers, arithmetic loop with " << instructions << " instructions\n";
+
+	MemoryCounters counters;
+	const bool countMemory = counters.Open();
+
+	Instance instance(executable);
+	for (bool pinned : { false, true })
+	{
+		instance.SetPinRegisters(pinned);
+		const double time = Measure(instance, 5);
+
+		std::cout << "[BENCH] " << (pinned ? "pinned registers: " : "memory registers: ") << time / 1e6 << " ms, " << time / instructions << " ns per instruction";
+
+		if (countMemory)
+		{
+			const auto [loads, stores] = counters.Count([&instance] { instance.Execute(); });
+			std::cout << ", " << static_cast<double>(loads) / instructions << " loads and "
+				<< static_cast<double>(stores) / instructions << " stores per instruction";
+		}
+		std::cout << "\n";
+	}
+
+	if (!countMemory)
+	{
+		std::cout << "[BENCH] Hardware counters for loads and stores aren't available on this system.\n";
+	}
+}
+
+void vman::bench::InstanceBenchmark(void)
+{
+	std::shared_ptr<Executable> executable = Executable::Create(Image(ArithmeticLoop(20000)));
+	if (executable == nullptr) return;
+
+	const std::uint64_t instructions = Count(executable).instructions;
+
+	constexpr const std::size_t INSTANCES = 4000;
+	std::vector<Instance> instances;
+	instances.reserve(INSTANCES);
+	for (std::size_t i = 0; i < INSTANCES; ++i)
+	{
+		instances.emplace_back(executable);
+	}
+
+	std::cout << "[BENCH] Instances, " << INSTANCES << " instances of an arithmetic loop with " << instructions << " instructions each\n";
+
+	std::vector<std::size_t> threadCounts = { 1 };
+	if (std::thread::hardware_concurrency() > 1) threadCounts.push_back(std::thread::hardware_concurrency());
+
+	double singleTime = 0.0;
+	for (std::size_t threads : threadCounts)
+	{
+		ThreadPool pool(threads);
+
+		const auto start = std::chrono::steady_clock::now();
+		for (Instance& instance : instances)
+		{
+			pool.Execute(instance);
+		}
+		pool.Wait();
+		const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+		if (threads == 1) singleTime = elapsed.count();
+
+		std::cout << "[BENCH] " << threads << (threads == 1 ? " thread:  " : " threads: ") << elapsed.count() / 1e6 << " ms, "
+			<< INSTANCES / (elapsed.count() / 1e9) << " instances per second, speedup " << singleTime / elapsed.count() << "x\n";
+	}
+}
+
+void vman::bench::VectorBenchmark(void)
+{
+	constexpr const s32 ITERATIONS = 2000;
+	constexpr const s32 ELEMENTS = 4096;
+	constexpr const double TOTAL = static_cast<double>(ITERATIONS) * ELEMENTS;
+
+	std::shared_ptr<Executable> vector = Executable::Create(Image(VectorLoop(ITERATIONS, ELEMENTS)));
+	std::shared_ptr<Executable> scalar = Executable::Create(Image(ScalarVectorLoop(ITERATIONS, ELEMENTS)));
+	if (vector == nullptr || scalar == nullptr) return;
+
+	std::cout << "[BENCH] Vectors, vadd and vmul over " << ELEMENTS << " elements " << ITERATIONS << " times\n";
+
+	Instance scalarInstance(scalar);
+	const double scalarTime = Measure(scalarInstance, 5);
+	std::cout << "[BENCH] load32 and store32 per element: " << scalarTime / 1e6 << " ms, " << scalarTime / TOTAL << " ns per element\n";
+
+	Instance vectorInstance(vector);
+	for (VectorLevel level : { VectorLevel::Scalar, VectorLevel::SSE2, VectorLevel::AVX2, VectorLevel::AVX512 })
+	{
+		if (!SelectVectorLevel(level)) continue;
+
+		const double time = Measure(vectorInstance, 5);
+		std::cout << "[BENCH] " << VectorLevelName(level) << " kernels: " << time / 1e6 << " ms, " << time / TOTAL
+			<< " ns per element, speedup " << scalarTime / time << "x\n";
+	}
+
+	SelectVectorLevel(DetectVectorLevel());
+}
+
+void vman::bench::BulkMemoryBenchmark(void)
+{
+	constexpr const s32 ITERATIONS = 2000;
+	constexpr const u32 SIZE = 4 * MEMORY_PAGE_SIZE;
+	constexpr const double TOTAL = static_cast<double>(ITERATIONS) * SIZE;
+
+	std::shared_ptr<Executable> bulk = Executable::Create(Image(CopyLoop(ITERATIONS, SIZE)));
+	std::shared_ptr<Executable> words = Executable::Create(Image(WordCopyLoop(ITERATIONS * static_cast<s32>(SIZE), SIZE)));
+	if (bulk == nullptr || words == nullptr) return;
+
+	std::cout << "[BENCH] Bulk memory, copying " << SIZE / 1024 << " KiB " << ITERATIONS << " times\n";
+
+	std::vector<Engine> engines = { { "switch", Dispatch::Switch } };
+#if VMAN_JIT
+	engines.push_back({ "jit", Dispatch::Jit });
+#endif
+
+	// Bytes per nanosecond are GB per second.
+	for (const Engine& engine : engines)
+	{
+		Instance instance(words);
+		instance.SetDispatch(engine.dispatch);
+		const double time = Measure(instance, 5);
+		std::cout << "[BENCH] load32 and store32, " << engine.name << ": " << time / 1e6 << " ms, " << TOTAL / time << " GB/s\n";
+	}
+
+	Instance instance(bulk);
+	const double time = Measure(instance, 5);
+	std::cout << "[BENCH] memcpy: " << time / 1e6 << " ms, " << TOTAL / time << " GB/s\n";
+}
+
+int vman::bench::Run(const Options& options)
+{
+	if (!SuiteBenchmark(options)) return -1;
+
+	// The register, instance, vector and bulk memory benchmarks don't belong to a workload, a filter skips them.
+	if (!options.filter.empty()) return 0;
+
+	RegisterBenchmark();
+	InstanceBenchmark();
+	VectorBenchmark();
+	BulkMemoryBenchmark();
+	return 0;
+}
\ No newline at end of file
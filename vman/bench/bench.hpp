@@ -0,0 +1,145 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "../core/types.hpp"
+#include "../core/interpreter.hpp"
+#include "../core/pool.hpp"
+
+namespace vman::bench
+{
+	/*
+	 * Builds VirtualMAN binaries in memory, so the benchmarks don't depend on hand made files.
+	 * The section table is written by Finish, the imports follow the code section.
+	**/
+	class ProgramWriter
+	{
+	private:
+		std::vector<char> bytes;
+
+		struct ImportEntry
+		{
+			u32 library;
+			u32 function;
+			u8 returnType;
+			std::vector<u8> paramTypes;
+		};
+
+		std::vector<ImportEntry> imports;
+
+		// Pages of linear memory, the memory section follows the imports.
+		u32 memoryPages = 0;
+
+		// Data, code, imports and memory.
+		static constexpr const u16 SECTIONS = 4;
+
+	public:
+		ProgramWriter(void);
+
+		// Address of the next byte that gets written.
+		u32 Here(void) const noexcept { return static_cast<u32>(bytes.size()); }
+
+		// Marks the current address as entry point, everything written before lands in the data section.
+		void Entry(void);
+
+		// Writes a zero terminated string into the data section and returns its address.
+		u32 String(const std::string&);
+
+		// Writes zeroed bytes into the data section and returns their address.
+		u32 Zero(std::size_t size);
+
+		// Writes a MOV and returns the address of the instruction, so the immediate can be patched later on.
+		u32 Mov(u8 reg, s32 value);
+		void Patch(u32 movAddress, s32 value);
+
+		void Op(u8 opcode, u8 a, u8 b, u8 c);
+		void Not(u8 a, u8 b);
+		void Vector(u8 opcode, u8 destination, u8 a, u8 b, u8 count);
+
+		// Writes a load or a store, the operands are ordered like in the assembly: "load32 r0, r1" and "store32 r1, r0".
+		void Access(u8 opcode, u8 a, u8 b);
+		void Memory(u32 pages) noexcept { memoryPages = pages; }
+		void Jmp(u8 reg);
+		void Nfc(u8 returnType, const std::vector<u8>& paramTypes);
+
+		// Declares an import whose names have been written through String and returns its index for Nfci.
+		u16 Import(u32 library, u32 function, u8 returnType, const std::vector<u8>& paramTypes);
+		void Nfci(u16 index);
+
+		std::vector<char> Finish(void) const;
+	};
+
+	struct Options
+	{
+		// Only workloads whose name contains this string are run, every workload if it's empty.
+		std::string filter;
+
+		// The results of the suite are written as JSON to this file as well, if it isn't empty.
+		std::string jsonPath;
+
+		// Every measurement keeps the fastest of this many runs.
+		int repetitions = 5;
+	};
+
+	/*
+	 * Runs every generated workload with switch dispatch, threaded dispatch and the JIT and reports
+	 * instructions per second, ns per dispatch and, for workloads with native calls, ns per native call.
+	 * The instructions and dispatches are counted through the profiler in a separate run, so the timed runs
+	 * aren't slowed down. Returns false if the JSON file couldn't be written.
+	**/
+	bool SuiteBenchmark(const Options&);
+
+	/*
+	 * Compares the interpreter with registers accessed through the context against pinned registers,
+	 * where available the loads and stores per instruction are measured through the hardware counters.
+	**/
+	void RegisterBenchmark(void);
+
+	/*
+	 * Runs many short lived instances of one shared executable through the thread pool,
+	 * once on a single worker and once on a worker for every hardware thread.
+	**/
+	void InstanceBenchmark(void);
+
+	/*
+	 * Runs the vector opcodes with the kernels of every instruction set the CPU supports
+	 * and compares them with a loop of scalar instructions that does the same work.
+	**/
+	void VectorBenchmark(void);
+
+	/*
+	 * Compares MEMCPY with a loop of word loads and stores that copies the same bytes, in GB per second.
+	**/
+	void BulkMemoryBenchmark(void);
+
+	int Run(const Options&);
+};
\ No newline at end of file
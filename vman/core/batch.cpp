@@ -0,0 +1,82 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "batch.hpp"
+#include "pool.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <filesystem>
+
+using vman::core::Batch;
+
+bool Batch::AddManifest(const std::string& path)
+{
+	std::ifstream manifest(path);
+	if (!manifest.is_open())
+	{
+		std::cerr << "[ERROR] Failed to open manifest " << path << ".\n";
+		return false;
+	}
+
+	const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+
+	std::string line;
+	while (std::getline(manifest, line))
+	{
+		// Manifests written on Windows end their lines with \r\n.
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line.empty() || line[0] == '#') continue;
+
+		const std::filesystem::path file(line);
+		files.push_back(file.is_absolute() ? file.string() : (directory / file).string());
+	}
+	return true;
+}
+
+std::size_t Batch::Run(const InterpreterContext& settings, std::size_t threads) const
+{
+	ThreadPool pool(threads);
+
+	// Every worker only ever touches its own context.
+	std::vector<InterpreterContext> contexts(pool.Size(), settings);
+	std::atomic<std::size_t> failed = 0;
+
+	for (const std::string& file : files)
+	{
+		pool.Submit([&contexts, &pool, &failed, &file]
+		{
+			InterpreterContext& context = contexts[pool.CurrentWorker()];
+			if (!context.OpenFile(file))
+			{
+				std::cerr << "[ERROR] Failed to load " << file << ".\n";
+				failed.fetch_add(1);
+				return;
+			}
+			if (context.Execute() == EXECUTION_FAILED) failed.fetch_add(1);
+		});
+	}
+
+	pool.Wait();
+	return failed.load();
+}
\ No newline at end of file
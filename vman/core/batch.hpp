@@ -0,0 +1,61 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <string>
+#include <vector>
+
+#include "types.hpp"
+#include "interpreter.hpp"
+
+namespace vman::core
+{
+	/*
+	 * Runs many binaries in one process instead of starting a process for every binary.
+	 * The binaries are spread over a work stealing thread pool, every worker keeps one context for all binaries it runs,
+	 * so it reuses the memory of the previous program and the dyncall VM of its thread.
+	**/
+	class Batch
+	{
+	private:
+		std::vector<std::string> files;
+
+	public:
+		void Add(const std::string& path) { files.push_back(path); }
+
+		/*
+		 * Adds every binary listed in a manifest, one path per line. Empty lines and lines starting with # are skipped,
+		 * relative paths are relative to the directory of the manifest.
+		**/
+		bool AddManifest(const std::string& path);
+
+		const std::vector<std::string>& Files(void) const noexcept { return files; }
+
+		/*
+		 * Runs every binary with the settings of the given context on the given number of threads,
+		 * 0 uses one thread per hardware thread. Returns the number of binaries that couldn't be loaded or were stopped by an exception.
+		**/
+		std::size_t Run(const InterpreterContext& settings, std::size_t threads = 0) const;
+	};
+};
\ No newline at end of file
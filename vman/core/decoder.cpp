@@ -0,0 +1,212 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "decoder.hpp"
+
+#include <cstring>
+
+using vman::core::Program;
+
+void Program::Clear(void) noexcept
+{
+	code.clear();
+	callSites.clear();
+	constants.clear();
+	imports = 0;
+	addressToIndex.clear();
+	codeStart = 0;
+	entry = 0;
+	usesMemory = false;
+	fused = false;
+}
+
+bool Program::DecodeImports(const Image& fileBytes, const Section& table)
+{
+	const auto validName = [&fileBytes](u32 address)
+	{
+		return address < fileBytes.size() && memchr(&fileBytes[address], '\0', fileBytes.size() - address) != nullptr;
+	};
+
+	for (std::size_t entry = table.offset; entry < table.end(); entry += IMPORT_ENTRY_SIZE)
+	{
+		CallSite site = {};
+		site.library = fileBytes.ReadU32(entry);
+		site.function = fileBytes.ReadU32(entry + 4);
+		site.returnType = static_cast<u8>(fileBytes[entry + 8]);
+		site.paramCount = static_cast<u8>(fileBytes[entry + 9]);
+
+		if (!validName(site.library) || !validName(site.function) || site.paramCount > MAX_NFC_PARAMS)
+		{
+			std::cerr << "[ERROR] Import " << callSites.size() << " is invalid.\n";
+			return false;
+		}
+
+		memcpy(site.paramTypes, &fileBytes[entry + 10], MAX_NFC_PARAMS);
+		callSites.push_back(site);
+	}
+
+	imports = static_cast<u32>(callSites.size());
+	return true;
+}
+
+bool Program::Decode(const Image& fileBytes, const ImageLayout& layout)
+{
+	Clear();
+
+	if (!DecodeImports(fileBytes, layout.imports)) return false;
+
+	const std::size_t size = layout.code.end();
+	codeStart = layout.code.offset;
+
+	/*
+	 * The end of the code section is a valid jump target as well, it maps to the HALT instruction.
+	**/
+	addressToIndex.assign(size - codeStart + 1, INVALID_INDEX);
+
+	const u8* bytes = reinterpret_cast<const u8*>(fileBytes.data());
+	std::size_t PC = codeStart;
+
+	while (PC < size)
+	{
+		const u8 opcode = Decoded(bytes[PC]);
+		const std::size_t length = InstructionLength(&bytes[PC], size - PC, layout.version == 1);
+
+		if (PC + length > size)
+		{
+			std::cerr << "[ERROR] Truncated instruction at 0x" << std::hex << PC << std::dec << ".\n";
+			return false;
+		}
+
+		Instruction instruction = { opcode, 0, 0, 0, 0, static_cast<u32>(PC) };
+		usesMemory |= AccessesMemory(opcode);
+
+		switch (OPCODES[opcode].operands)
+		{
+			case Operands::None:
+				break;
+
+			case Operands::Register:
+			case Operands::TwoRegisters:
+			case Operands::ThreeRegisters:
+				instruction.a = bytes[PC + 1];
+				instruction.b = length > 2 ? bytes[PC + 2] : 0;
+				instruction.c = length > 3 ? bytes[PC + 3] : 0;
+
+				// Jumps get their target from the verifier, if it can be resolved ahead of time.
+				if (opcode == JMP || opcode == JIE || opcode == JNE) instruction.imm = static_cast<s32>(INVALID_INDEX);
+				break;
+
+			case Operands::RegisterImmediate:
+				instruction.a = bytes[PC + 1];
+				instruction.imm = Immediate(&bytes[PC]);
+				break;
+
+			case Operands::FourRegisters:
+				instruction.a = bytes[PC + 1];
+				instruction.b = bytes[PC + 2];
+				instruction.c = bytes[PC + 3];
+				instruction.imm = bytes[PC + 4];
+				break;
+
+			case Operands::RegisterWide:
+				instruction.a = bytes[PC + 1];
+				instruction.imm = static_cast<s32>(constants.size());
+				constants.push_back(WideImmediate(&bytes[PC]));
+				break;
+
+			case Operands::Types:
+			{
+				/*
+				 * The opcode is followed by the return type and a zero terminated list of parameter types,
+				 * the padding byte behind the terminator of version 1 binaries isn't a parameter.
+				**/
+				CallSite site = {};
+				site.returnType = bytes[PC + 1];
+
+				std::size_t count = 0;
+				while (bytes[PC + 2 + count]) ++count;
+
+				if (count > MAX_NFC_PARAMS)
+				{
+					std::cerr << "[ERROR] Too many parameters for native call at 0x" << std::hex << PC << std::dec << ".\n";
+					return false;
+				}
+
+				site.paramCount = static_cast<u8>(count);
+				for (u8 i = 0; i < site.paramCount; ++i)
+				{
+					site.paramTypes[i] = bytes[PC + 2 + i];
+				}
+
+				instruction.imm = static_cast<s32>(callSites.size());
+				callSites.push_back(site);
+			} break;
+
+			case Operands::Import:
+				instruction.imm = ImportIndex(&bytes[PC]);
+				if (static_cast<u32>(instruction.imm) >= imports)
+				{
+					std::cerr << "[ERROR] Unknown import " << instruction.imm << " at 0x" << std::hex << PC << std::dec << ".\n";
+					return false;
+				}
+				break;
+		}
+
+		addressToIndex[PC - codeStart] = static_cast<u32>(code.size());
+		code.push_back(instruction);
+		PC += length;
+	}
+
+	addressToIndex[size - codeStart] = static_cast<u32>(code.size());
+	code.push_back({ HALT, 0, 0, 0, 0, static_cast<u32>(size) });
+
+	entry = IndexOf(layout.entry);
+	if (entry == INVALID_INDEX)
+	{
+		std::cerr << "[ERROR] Entry point doesn't start an instruction.\n";
+		return false;
+	}
+	return true;
+}
+
+bool Program::Fuse(bool enable)
+{
+	if (fused == enable) return false;
+	fused = enable;
+
+	bool changed = false;
+	for (std::size_t i = 0; i + 1 < code.size(); ++i)
+	{
+		u8 opcode = Unfused(code[i].opcode);
+		if (enable)
+		{
+			// The following instruction hasn't been visited yet, so its opcode is still the original one.
+			const u8 superinstruction = Superinstruction(opcode, code[i + 1].opcode);
+			if (superinstruction != NOP) opcode = superinstruction;
+		}
+
+		changed |= code[i].opcode != opcode;
+		code[i].opcode = opcode;
+	}
+	return changed;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <vector>
+#include <cstddef>
+#include <iostream>
+
+#include "types.hpp"
+#include "opcodes.hpp"
+#include "image.hpp"
+
+namespace vman::core
+{
+	// Returns the superinstruction for two opcodes that follow each other, NOP if there is none.
+	constexpr u8 Superinstruction(u8 first, u8 second) noexcept
+	{
+		if (first == MOV && second == MOV) return MOV_MOV;
+		if (first == MOV && second == ADD) return MOV_ADD;
+		if (first == SUB && second == JNE) return SUB_JNE;
+		if (first == ADD && second == JNE) return ADD_JNE;
+		return NOP;
+	}
+
+	// Returns the opcode a superinstruction starts with, every other opcode is returned as it is.
+	constexpr u8 Unfused(u8 opcode) noexcept
+	{
+		switch (opcode)
+		{
+			case MOV_MOV:
+			case MOV_ADD:
+				return MOV;
+
+			case SUB_JNE:
+				return SUB;
+
+			case ADD_JNE:
+				return ADD;
+
+			default:
+				return opcode;
+		}
+	}
+
+	/*
+	 * Returned for addresses that don't point to the first byte of an instruction.
+	**/
+	constexpr const u32 INVALID_INDEX = 0xFFFFFFFF;
+
+	/*
+	 * Register 0 and 1 are reserved for the library and function name of NFC,
+	 * this leaves the registers 2 to 11 for parameters.
+	**/
+	constexpr const std::size_t MAX_NFC_PARAMS = 10;
+
+	constexpr const std::size_t REGISTER_COUNT = 12;
+
+	/*
+	 * A decoded instruction, every instruction has the same width no matter how long its encoding is.
+	 * The meaning of the operands depends on the opcode:
+	 *
+	 * ADD - XOR: a = destination register, b and c = source registers
+	 * NOT: a = destination register, b = source register
+	 * ADDX - FTOI: like ADD - XOR and NOT, the bank of each register is listed in OPCODES
+	 * LOAD8 - LOADF: a = destination register, b = register with the address
+	 * STORE8 - STOREF: a = register with the address, b = source register
+	 * MOV: a = destination register, imm = immediate value
+	 * MOVX, MOVF: a = destination register, imm = index of the 64 bit immediate in the constants of the program
+	 * VADD - VDOTF: a = register with the destination address, or the result register of VDOT and VDOTF,
+	 *               b and c = registers with the source addresses, imm = register with the number of elements
+	 * MEMCPY, MEMSET: a = register with the destination address, b = register with the source address or the value,
+	 *                 c = register with the number of bytes
+	 * MEMCMP: a = result register, b and c = registers with the addresses, imm = register with the number of bytes
+	 * JMP: a = register that holds the target address, imm = index of the target if the verifier resolved it, INVALID_INDEX otherwise
+	 * JIE, JNE: a and b = compared registers, c = register that holds the target address, imm like JMP
+	 * NFC: imm = index of the call site
+	 * NFCI: imm = index of the call site, which is the index of the import
+	**/
+	struct Instruction
+	{
+		u8 opcode;
+		u8 a;
+		u8 b;
+		u8 c;
+		s32 imm;
+
+		// Address of the instruction inside the binary file, used for error messages.
+		u32 address;
+	};
+
+	/*
+	 * The type list that follows an NFC opcode, decoded once so it doesn't have to be walked on every call.
+	 * Imports are call sites as well, they know the addresses of their names up front.
+	**/
+	struct CallSite
+	{
+		u8 returnType;
+		u8 paramCount;
+		u8 paramTypes[MAX_NFC_PARAMS];
+
+		// Addresses of the library and function name of an import, NFC takes them from register 0 and 1 instead.
+		u32 library = 0;
+		u32 function = 0;
+
+		// Set by the verifier if every parameter always points into the binary, so the values don't have to be checked.
+		bool verified = false;
+	};
+
+	class Program
+	{
+	private:
+		/*
+		 * Maps every address of the code section to the index of the instruction that starts there.
+		 * Jumps in VirtualMAN take their target from a register, so the target can only be resolved at runtime,
+		 * this table turns that into a single lookup.
+		**/
+		std::vector<u32> addressToIndex;
+		std::size_t codeStart = 0;
+		bool fused = false;
+
+		bool DecodeImports(const Image& fileBytes, const Section& table);
+
+	public:
+		std::vector<Instruction> code;
+		// The imports come first, so the call site of NFCI is the index of its import.
+		std::vector<CallSite> callSites;
+		u32 imports = 0;
+
+		// The immediates of MOVX and MOVF, the bits of a double for MOVF.
+		std::vector<u64> constants;
+
+		// Index of the instruction the execution starts with.
+		u32 entry = 0;
+
+		// Set if any instruction loads or stores, instances only reserve linear memory for these programs or if the binary asks for it.
+		bool usesMemory = false;
+
+		/*
+		 * Decodes the code section of a binary file, the entry point has to be the first byte of an instruction.
+		 * Unknown opcodes are treated as NOP, just as the interpreter always did.
+		**/
+		bool Decode(const Image& fileBytes, const ImageLayout& layout);
+
+		// Removes the decoded program, the memory is kept for the next one.
+		void Clear(void) noexcept;
+
+		/*
+		 * Turns frequent pairs of instructions into superinstructions, so the interpreter only dispatches once for both.
+		 * Passing false restores the original instructions. Returns true if any instruction has been changed.
+		**/
+		bool Fuse(bool enable);
+		bool Fused(void) const noexcept { return fused; }
+
+		u32 IndexOf(std::size_t address) const noexcept
+		{
+			address -= codeStart;
+			return address < addressToIndex.size() ? addressToIndex[address] : INVALID_INDEX;
+		}
+	};
+};
\ No newline at end of file
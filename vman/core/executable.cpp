@@ -0,0 +1,252 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "executable.hpp"
+#include "pool.hpp"
+
+#include <algorithm>
+#include <filesystem>
+
+using vman::core::Executable;
+
+std::shared_ptr<Executable> Executable::Open(const std::string& path)
+{
+	Image image;
+	if (!image.Map(path)) return nullptr;
+
+	if (IsNativeModule(image)) return OpenNative(path);
+	return Create(std::move(image));
+}
+
+bool Executable::IsNativeModule(const Image& image) noexcept
+{
+	if (image.size() < 4) return false;
+
+	const u32 magic = image.ReadU32(0);
+	return magic == 0x464C457F ||                                        // "\x7FELF"
+		(magic & 0xFFFF) == 0x5A4D ||                                    // "MZ"
+		magic == 0xFEEDFACE || magic == 0xFEEDFACF || magic == 0xCAFEBABE; // Mach-O, thin and universal
+}
+
+std::shared_ptr<Executable> Executable::OpenNative(const std::string& path)
+{
+	/*
+	 * Without a path, the library would be searched in the system directories instead of the given file.
+	**/
+	const std::string module = std::filesystem::absolute(path).string();
+	if (vmb::platform::LoadModule(module.c_str()) == nullptr)
+	{
+		std::cerr << "[ERROR] Failed to load the compiled program " << path << ".\n";
+		return nullptr;
+	}
+
+	const auto abi = static_cast<const u32*>(vmb::platform::FindSymbol(module.c_str(), NATIVE_ABI_SYMBOL));
+	const auto bytes = static_cast<const char*>(vmb::platform::FindSymbol(module.c_str(), NATIVE_IMAGE_SYMBOL));
+	const auto size = static_cast<const u32*>(vmb::platform::FindSymbol(module.c_str(), NATIVE_IMAGE_SIZE_SYMBOL));
+	const auto entry = reinterpret_cast<NativeEntry>(vmb::platform::FindSymbol(module.c_str(), NATIVE_ENTRY_SYMBOL));
+
+	if (abi == nullptr || bytes == nullptr || size == nullptr || entry == nullptr)
+	{
+		std::cerr << "[ERROR] " << path << " isn't a compiled virtual man program.\n";
+		return nullptr;
+	}
+
+	if (*abi != NATIVE_ABI)
+	{
+		std::cerr << "[ERROR] " << path << " has been compiled for another version of virtual man.\n";
+		return nullptr;
+	}
+
+	/*
+	 * The image gets copied, native functions may write into its data section, the library keeps its own copy untouched.
+	**/
+	auto executable = Create(Image(std::vector<char>(bytes, bytes + *size)));
+	if (executable == nullptr) return nullptr;
+
+	executable->native = entry;
+	return executable;
+}
+
+std::shared_ptr<Executable> Executable::Create(Image&& image)
+{
+	auto executable = std::make_shared<Executable>();
+	if (!executable->Load(std::move(image))) return nullptr;
+
+	return executable;
+}
+
+bool Executable::Load(Image&& image)
+{
+	fileBytes = std::move(image);
+	program.Clear();
+	callPlans.clear();
+	symbols.clear();
+	symbolCache.reset();
+	jit.Reset();
+	native = nullptr;
+	for (std::atomic<bool>& ready : threadedReady) ready = false;
+
+	/*
+	 * The header tells where the code section is, either through the section table or through the entry point.
+	**/
+	if (!ReadLayout(fileBytes, layout)) return false;
+
+	/*
+	 * Every instruction is decoded a single time here, the interpreter only runs the decoded instructions.
+	**/
+	if (!program.Decode(fileBytes, layout)) return false;
+
+	/*
+	 * The interpreter doesn't check registers and static jump targets, the verifier makes sure it doesn't have to.
+	**/
+	if (!Verify(program, fileBytes)) return false;
+
+	symbolCache = std::make_unique<std::atomic<const Symbol*>[]>(program.callSites.size());
+	for (std::size_t i = 0; i < program.callSites.size(); ++i)
+	{
+		const CallSite& site = program.callSites[i];
+		callPlans.push_back(vmb::Bridge::Plan(site.returnType, site.paramTypes, site.paramCount));
+		symbolCache[i].store(nullptr, std::memory_order_relaxed);
+	}
+
+	if (!ResolveImports()) return false;
+
+	/*
+	 * Binaries expect User32.dll to be loaded, it only has to be done once per process.
+	**/
+	static std::once_flag user32;
+	std::call_once(user32, [] { vmb::platform::LoadModule("User32.dll"); });
+	return true;
+}
+
+bool Executable::ResolveImports(void)
+{
+	imports.assign(program.imports, nullptr);
+
+	/*
+	 * Loading a library and looking up its symbols takes a while, so the imports are resolved on several threads.
+	**/
+	if (program.imports > 1)
+	{
+		ThreadPool pool(std::min<std::size_t>(program.imports, std::max(1u, std::thread::hardware_concurrency())));
+		for (u32 i = 0; i < program.imports; ++i)
+		{
+			const CallSite& site = program.callSites[i];
+			pool.Submit([this, i, &site] { imports[i] = vmb::Bridge::ResolveSymbol(&fileBytes[site.library], &fileBytes[site.function]); });
+		}
+		pool.Wait();
+	}
+	else if (program.imports == 1)
+	{
+		const CallSite& site = program.callSites[0];
+		imports[0] = vmb::Bridge::ResolveSymbol(&fileBytes[site.library], &fileBytes[site.function]);
+	}
+
+	/*
+	 * Every missing function is reported, the binary doesn't start if any of them is missing.
+	**/
+	bool resolved = true;
+	for (u32 i = 0; i < program.imports; ++i)
+	{
+		const CallSite& site = program.callSites[i];
+		if (imports[i] == nullptr)
+		{
+			std::cerr << "[ERROR] Failed to resolve native function " << &fileBytes[site.function] << " from " << &fileBytes[site.library] << ".\n";
+			resolved = false;
+		}
+		else if (callPlans[i].caller == nullptr)
+		{
+			std::cerr << "[ERROR] Native function " << &fileBytes[site.function] << " has an unsupported return type.\n";
+			resolved = false;
+		}
+	}
+	return resolved;
+}
+
+void Executable::Fuse(bool enable)
+{
+	/*
+	 * Superinstructions change the opcodes of the decoded program, the handler tables have to follow.
+	**/
+	if (program.Fuse(enable))
+	{
+		for (std::atomic<bool>& ready : threadedReady) ready = false;
+	}
+}
+
+void* Executable::ResolveNativeFunction(const vmb::Bridge& b, u32 site, u32 library, u32 function) const
+{
+	const u64 key = (static_cast<u64>(library) << 32) | function;
+
+	const Symbol* cached = symbolCache[site].load(std::memory_order_acquire);
+	if (cached != nullptr && cached->first == key) return cached->second;
+
+	/*
+	 * The call site either runs for the first time or calls another function than last time.
+	 * Other call sites might have resolved the function already, only unknown functions are looked up.
+	**/
+	std::lock_guard<std::mutex> guard(symbolLock);
+
+	/*
+	 * Failures are remembered as nullptr, so a call site that keeps calling a missing function doesn't look it up
+	 * and report it on every execution.
+	**/
+	auto it = symbols.find(key);
+	if (it == symbols.end())
+	{
+		void* symbol = nullptr;
+		if (library >= fileBytes.size() || function >= fileBytes.size() ||
+			memchr(&fileBytes[library], '\0', fileBytes.size() - library) == nullptr ||
+			memchr(&fileBytes[function], '\0', fileBytes.size() - function) == nullptr)
+		{
+			std::cerr << "[ERROR] The name of the native function is outside of the binary.\n";
+		}
+		else
+		{
+			symbol = b.ResolveSymbol(&fileBytes[library], &fileBytes[function]);
+			if (symbol == nullptr) std::cerr << "[ERROR] Failed to resolve native function " << &fileBytes[function] << " from " << &fileBytes[library] << ".\n";
+		}
+		it = symbols.emplace(key, symbol).first;
+	}
+
+	symbolCache[site].store(&*it, std::memory_order_release);
+	return it->second;
+}
+
+const void* const* Executable::ThreadedCode(std::size_t table, const void* const (&handlers)[256]) const
+{
+	if (!threadedReady[table].load(std::memory_order_acquire))
+	{
+		std::lock_guard<std::mutex> guard(threadedLock);
+		if (!threadedReady[table].load(std::memory_order_relaxed))
+		{
+			threadedCode[table].resize(program.code.size());
+			for (std::size_t i = 0; i < program.code.size(); ++i)
+			{
+				threadedCode[table][i] = handlers[program.code[i].opcode];
+			}
+			threadedReady[table].store(true, std::memory_order_release);
+		}
+	}
+	return threadedCode[table].data();
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "types.hpp"
+#include "opcodes.hpp"
+#include "image.hpp"
+#include "decoder.hpp"
+#include "verifier.hpp"
+#include "jit.hpp"
+#include "native.hpp"
+#include "../vmb/vmb.hpp"
+
+namespace vman::core
+{
+	/*
+	 * A loaded binary: its image, the decoded program and the plans of its native calls.
+	 * It is loaded once and shared by any number of instances through a std::shared_ptr<const Executable>.
+	 * Everything an instance fills in while running, the symbol cache, the JIT and the handler tables
+	 * of threaded dispatch, is synchronized, so instances on different threads can run the same executable.
+	 * The image itself is never written, instances copy it before native functions or vector instructions write into it.
+	**/
+	class Executable
+	{
+	private:
+		/*
+		 * During startup, virtual man maps the binary into memory.
+		 * VirtualMAN handles code through memory IO rather than file IO.
+		**/
+		Image fileBytes;
+
+		// The sections of fileBytes, read from its header.
+		ImageLayout layout;
+
+		/*
+		 * The code section of fileBytes, decoded once while loading the file.
+		 * Instances run these instructions instead of decoding each byte over and over again.
+		**/
+		Program program;
+
+		// How the values of every NFC call site get passed to the native function.
+		std::vector<vmb::Bridge::CallPlan> callPlans;
+
+		using Symbol = std::pair<const u64, void*>;
+
+		/*
+		 * Every symbol that has been looked up so far, indexed by library offset << 32 | function offset,
+		 * nullptr for the ones that couldn't be resolved.
+		 * The nodes of an unordered_map never move, so call sites can point at them.
+		**/
+		mutable std::unordered_map<u64, void*> symbols;
+		mutable std::mutex symbolLock;
+
+		/*
+		 * The symbol that each NFC call site called last time. A call site that keeps calling the same function
+		 * only compares the offsets of the names and skips the lock.
+		**/
+		mutable std::unique_ptr<std::atomic<const Symbol*>[]> symbolCache;
+
+		// The function of every import, they are all resolved while loading, so NFCI never has to look anything up.
+		std::vector<void*> imports;
+
+		mutable JitCompiler jit;
+
+		// The compiled program if the executable has been loaded from a module that "vman -c" generated.
+		NativeEntry native = nullptr;
+
+		/*
+		 * The address of the handler for each decoded instruction, used by threaded dispatch.
+		 * Every instantiation of the interpreter loop has its own handlers, so there is one table for each of them.
+		**/
+		static constexpr std::size_t HANDLER_TABLES = 4;
+		mutable std::array<std::vector<const void*>, HANDLER_TABLES> threadedCode;
+		mutable std::array<std::atomic<bool>, HANDLER_TABLES> threadedReady = {};
+		mutable std::mutex threadedLock;
+
+		bool ResolveImports(void);
+
+	public:
+		Executable(void) = default;
+		Executable(const Executable&) = delete;
+		Executable& operator=(const Executable&) = delete;
+
+		/*
+		 * Maps a binary file and loads it, returns nullptr if the file isn't a compatible binary.
+		**/
+		static std::shared_ptr<Executable> Open(const std::string& path);
+		static std::shared_ptr<Executable> Create(Image&&);
+
+		/*
+		 * Loads a shared library that has been compiled from the output of "vman -c". The image embedded in the library
+		 * is loaded like any other binary, so the decoded program, the call plans and the imports are the same ones
+		 * the translator saw. Returns nullptr if the library doesn't export a compatible program.
+		**/
+		static std::shared_ptr<Executable> OpenNative(const std::string& path);
+
+		// Returns true if the image starts like a shared library (ELF, PE or Mach-O) instead of a virtual man binary.
+		static bool IsNativeModule(const Image&) noexcept;
+
+		/*
+		 * Validates the header of the binary and decodes it. A previously loaded binary gets replaced,
+		 * the memory of its program is reused. This must not happen while any instance runs the executable.
+		**/
+		bool Load(Image&&);
+
+		/*
+		 * Replaces frequent instruction pairs with superinstructions, or restores the original instructions.
+		 * This changes the program, so it must not happen while any instance runs it.
+		**/
+		void Fuse(bool enable);
+
+		const Image& Bytes(void) const noexcept { return fileBytes; }
+		const ImageLayout& Layout(void) const noexcept { return layout; }
+		const Program& Code(void) const noexcept { return program; }
+		const vmb::Bridge::CallPlan& Plan(u32 site) const noexcept { return callPlans[site]; }
+
+		/*
+		 * Returns the native function whose library and function name are located at the given offsets of the binary,
+		 * nullptr if it can't be resolved. The result is remembered for the call site and for the whole executable,
+		 * a failure as well, it's only reported once.
+		**/
+		void* ResolveNativeFunction(const vmb::Bridge&, u32 site, u32 library, u32 function) const;
+
+		// The resolved function of an import, the call sites of the imports come first.
+		void* Import(u32 site) const noexcept { return imports[site]; }
+		void* const* Imports(void) const noexcept { return imports.data(); }
+
+		// The compiled program, nullptr unless the executable has been opened through OpenNative.
+		NativeEntry Native(void) const noexcept { return native; }
+
+		/*
+		 * Compiles the program on first use, returns false if the JIT isn't available.
+		**/
+		bool CompileJit(void) const { return jit.Compile(program); }
+		JitBlock Block(u32 index) const { return jit.Block(program, index); }
+
+		/*
+		 * Returns the handler table of an instantiation of the interpreter loop, it gets built on first use
+		 * from the handler of each opcode.
+		**/
+		const void* const* ThreadedCode(std::size_t table, const void* const (&handlers)[256]) const;
+	};
+};
\ No newline at end of file
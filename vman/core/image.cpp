@@ -0,0 +1,211 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "image.hpp"
+
+#include <iostream>
+#include <utility>
+
+using vman::core::Image;
+
+using namespace vman;
+using namespace vman::core;
+
+namespace
+{
+	bool ReadSectionTable(const Image& image, ImageLayout& layout)
+	{
+		layout.version = image.ReadU16(0x14);
+		if (layout.version < 2 || layout.version > IMAGE_VERSION)
+		{
+			std::cerr << "[ERROR] Binary version " << layout.version << " isn't supported.\n";
+			return false;
+		}
+
+		const std::size_t count = image.ReadU16(0x16);
+		const std::size_t tableEnd = SECTIONED_HEADER_SIZE + count * SECTION_ENTRY_SIZE;
+		if (tableEnd > image.size())
+		{
+			std::cerr << "[ERROR] The section table is truncated.\n";
+			return false;
+		}
+
+		bool hasCode = false;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const std::size_t entry = SECTIONED_HEADER_SIZE + i * SECTION_ENTRY_SIZE;
+			const u32 type = image.ReadU32(entry);
+			const Section section = { image.ReadU32(entry + 4), image.ReadU32(entry + 8) };
+
+			if (section.offset < tableEnd || static_cast<u64>(section.offset) + section.size > image.size())
+			{
+				std::cerr << "[ERROR] Section " << i << " lies outside of the binary.\n";
+				return false;
+			}
+
+			Section* target = nullptr;
+			switch (static_cast<SectionType>(type))
+			{
+				case SectionType::Code: target = &layout.code; hasCode = true; break;
+				case SectionType::Data: target = &layout.data; break;
+				case SectionType::Imports: target = &layout.imports; break;
+				case SectionType::Relocations: target = &layout.relocations; break;
+				case SectionType::Debug: target = &layout.debug; break;
+				case SectionType::Memory: target = &layout.memory; break;
+
+				// Sections of later versions of the format are skipped, they only add information.
+				default: continue;
+			}
+
+			if (!target->empty())
+			{
+				std::cerr << "[ERROR] Section " << i << " is defined twice.\n";
+				return false;
+			}
+			*target = section;
+		}
+
+		if (layout.imports.size % IMPORT_ENTRY_SIZE != 0 || layout.relocations.size % 4 != 0 || layout.debug.size % 8 != 0 ||
+			(!layout.memory.empty() && layout.memory.size != 4))
+		{
+			std::cerr << "[ERROR] The size of a section doesn't match its entries.\n";
+			return false;
+		}
+
+		if (!layout.memory.empty())
+		{
+			layout.memoryPages = image.ReadU32(layout.memory.offset);
+			if (layout.memoryPages > MAX_MEMORY_PAGES)
+			{
+				std::cerr << "[ERROR] The binary asks for more than 4 GiB of linear memory.\n";
+				return false;
+			}
+		}
+
+		// The end of the code section is a valid entry point as well, the program ends right away then.
+		if (!hasCode || layout.entry < layout.code.offset || layout.entry > layout.code.end())
+		{
+			std::cerr << "[ERROR] Entry point lies outside of the code section.\n";
+			return false;
+		}
+		return true;
+	}
+};
+
+bool vman::core::ReadLayout(const Image& image, ImageLayout& layout)
+{
+	layout = {};
+
+	/*
+	 * Virtual man checks here if the given binary file has the 1911 KUQEZI signature,
+	 * if virtual man can't detect this signature, it will refuse to disassemble or execute the binary.
+	**/
+	if (image.size() < HEADER_SIZE || image.ReadU64(8) != SIGNATURE)
+	{
+		std::cerr << "[ERROR] This is not a compatible virtual man binary.\n";
+		return false;
+	}
+
+	// Addresses inside the virtual machine are 32 bits wide.
+	const u64 entry = image.ReadU64(0);
+	if (image.size() > UINT32_MAX || entry > image.size())
+	{
+		std::cerr << "[ERROR] Entry point lies outside of the binary.\n";
+		return false;
+	}
+	layout.entry = static_cast<u32>(entry);
+
+	if (image.size() >= SECTIONED_HEADER_SIZE && image.ReadU32(0x10) == SECTION_MAGIC)
+	{
+		return ReadSectionTable(image, layout);
+	}
+
+	/*
+	 * Version 1: the data section lies between the header and the entry point, the code section follows up to the end.
+	**/
+	const u32 size = static_cast<u32>(image.size());
+	layout.code = { layout.entry, size - layout.entry };
+	if (layout.entry > HEADER_SIZE) layout.data = { static_cast<u32>(HEADER_SIZE), layout.entry - static_cast<u32>(HEADER_SIZE) };
+	return true;
+}
+
+Image::Image(std::vector<char>&& buffer) noexcept
+	: owned(std::move(buffer))
+{
+	bytes = owned.data();
+	length = owned.size();
+}
+
+Image::Image(Image&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+Image& Image::operator=(Image&& other) noexcept
+{
+	if (this != &other)
+	{
+		Release();
+
+		// The data of a moved vector stays where it is, so bytes remains valid for both kinds of images.
+		mapping = other.mapping;
+		owned = std::move(other.owned);
+		bytes = other.bytes;
+		length = other.length;
+
+		other.mapping = { nullptr, 0 };
+		other.owned.clear();
+		other.bytes = nullptr;
+		other.length = 0;
+	}
+	return *this;
+}
+
+Image::~Image(void)
+{
+	Release();
+}
+
+void Image::Release(void) noexcept
+{
+	vmb::platform::UnmapFile(mapping);
+	owned.clear();
+	owned.shrink_to_fit();
+	bytes = nullptr;
+	length = 0;
+}
+
+bool Image::Map(const std::string& path)
+{
+	Release();
+
+	if (!vmb::platform::MapFile(path.c_str(), mapping))
+	{
+		std::cerr << "[ERROR] Failed to open file.\n";
+		return false;
+	}
+
+	bytes = mapping.data;
+	length = mapping.size;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "types.hpp"
+#include "../vmb/platform.hpp"
+
+namespace vman::core
+{
+	/*
+	 * Every binary starts with the address of its entry point followed by the 1911 KUQEZI signature.
+	**/
+	constexpr const u64 SIGNATURE = 0x495A4551554B1119;
+
+	/*
+	 * Version 2 binaries continue the header with this magic, their version and the number of sections,
+	 * followed by the section table. Version 1 binaries continue with the data section right away,
+	 * their code section reaches from the entry point up to the end of the file.
+	 * The code section of a version 2 binary is placed last, so older versions of virtual man can still run it,
+	 * unless it contains NFC: since version 2, NFC ends with the terminator of its type list instead of one byte behind it.
+	**/
+	constexpr const u32 SECTION_MAGIC = 0x43455356; // "VSEC"
+	constexpr const u16 IMAGE_VERSION = 2;
+
+	constexpr const std::size_t HEADER_SIZE = 0x10;
+	constexpr const std::size_t SECTIONED_HEADER_SIZE = 0x18;
+	constexpr const std::size_t SECTION_ENTRY_SIZE = 0x10;
+
+	/*
+	 * Every entry of the section table consists of the type, the offset and the size of the section inside
+	 * the file and a reserved field, all of them 32 bit little endian values. Addresses stay offsets into the file,
+	 * so the sections only describe the binary, it is still mapped as a whole.
+	**/
+	enum class SectionType : u32
+	{
+		Code = 1,        // Instructions, the entry point lies inside of it.
+		Data = 2,        // Strings and other constants.
+		Imports = 3,     // Native functions the binary calls through NFCI, see IMPORT_ENTRY_SIZE.
+		Relocations = 4, // Addresses of the MOV immediates that hold an address, one 32 bit value each, sorted.
+		Debug = 5,       // Pairs of an instruction address and its source line, sorted by address.
+		Memory = 6,      // The number of pages of linear memory every instance gets, a single 32 bit value.
+	};
+
+	/*
+	 * Every import consists of the addresses of the zero terminated library and function names, the return type,
+	 * the number of parameters and the parameter types, padded with zeros up to MAX_NFC_PARAMS.
+	 * Its index in the table is the operand of NFCI.
+	**/
+	constexpr const std::size_t IMPORT_ENTRY_SIZE = 0x14;
+
+	/*
+	 * Linear memory is allocated in pages of 64 KiB, up to the 4 GiB a 32 bit address reaches.
+	**/
+	constexpr const std::size_t MEMORY_PAGE_SIZE = 0x10000;
+	constexpr const u32 MAX_MEMORY_PAGES = 0x10000;
+
+	struct Section
+	{
+		u32 offset = 0;
+		u32 size = 0;
+
+		u32 end(void) const noexcept { return offset + size; }
+		bool empty(void) const noexcept { return size == 0; }
+	};
+
+	/*
+	 * Where the parts of a binary are located, read from the section table or derived from the entry point.
+	**/
+	struct ImageLayout
+	{
+		u16 version = 1;
+		u32 entry = 0;
+
+		Section code;
+		Section data;
+		Section imports;
+		Section relocations;
+		Section debug;
+		Section memory;
+
+		// Read from the memory section, 0 if the binary doesn't have one.
+		u32 memoryPages = 0;
+	};
+
+	class Image;
+
+	/*
+	 * Validates the header and the section table, every section has to lie inside the file.
+	 * Prints the reason and returns false if the binary isn't compatible.
+	**/
+	bool ReadLayout(const Image&, ImageLayout&);
+
+	/*
+	 * The bytes of a binary, shared by the interpreter and the disassembler.
+	 * Files are mapped into memory instead of being read into a private copy, so every process that runs the same binary
+	 * shares its pages. Instances write into a copy of their own, the mapping stays untouched.
+	 * Binaries that have been built in memory are moved into the image instead.
+	**/
+	class Image
+	{
+	private:
+		vmb::platform::MappedFile mapping = { nullptr, 0 };
+		std::vector<char> owned;
+
+		// Mapped files are read only, the image never gets written to.
+		const char* bytes = nullptr;
+		std::size_t length = 0;
+
+		void Release(void) noexcept;
+
+	public:
+		Image(void) = default;
+		explicit Image(std::vector<char>&&) noexcept;
+		Image(Image&&) noexcept;
+		Image& operator=(Image&&) noexcept;
+		Image(const Image&) = delete;
+		Image& operator=(const Image&) = delete;
+		~Image(void);
+
+		/*
+		 * Maps the file at the given path, the previous content of the image gets released.
+		**/
+		bool Map(const std::string& path);
+
+		const char* data(void) const noexcept { return bytes; }
+		std::size_t size(void) const noexcept { return length; }
+		bool empty(void) const noexcept { return length == 0; }
+
+		const char& operator[](std::size_t index) const noexcept { return bytes[index]; }
+
+		const char* begin(void) const noexcept { return bytes; }
+		const char* end(void) const noexcept { return bytes + length; }
+
+		// Little endian values of the header and the sections, the offset has to be in range.
+		u16 ReadU16(std::size_t offset) const noexcept
+		{
+			return static_cast<u16>(static_cast<u8>(bytes[offset]) | static_cast<u8>(bytes[offset + 1]) << 8);
+		}
+
+		u32 ReadU32(std::size_t offset) const noexcept
+		{
+			return static_cast<u32>(ReadU16(offset)) | static_cast<u32>(ReadU16(offset + 2)) << 16;
+		}
+
+		u64 ReadU64(std::size_t offset) const noexcept
+		{
+			return static_cast<u64>(ReadU32(offset)) | static_cast<u64>(ReadU32(offset + 4)) << 32;
+		}
+	};
+};
\ No newline at end of file
@@ -24,283 +24,1099 @@
 #include "interpreter.hpp"
 
 using vman::core::InterpreterContext;
+using vman::core::Instance;
+
+namespace
+{
+	using namespace vman;
+
+	/*
+	 * Arithmetic on both integer banks wraps around like the hardware does, signed overflow would be undefined in C++.
+	 * The minimum divided by -1 doesn't fit either, it wraps as well. The divisor has been checked for zero already.
+	**/
+	s64 Wrap(u64 value) noexcept { return static_cast<s64>(value); }
+	s32 Wrap(u32 value) noexcept { return static_cast<s32>(value); }
+	s64 DivideWide(s64 a, s64 b) noexcept { return b == -1 ? Wrap(0 - static_cast<u64>(a)) : a / b; }
+	s64 RemainderWide(s64 a, s64 b) noexcept { return b == -1 ? 0 : a % b; }
+
+	// The same for the r registers, the JIT leaves both divisors to the interpreter.
+	s32 Divide(s32 a, s32 b) noexcept { return b == -1 ? Wrap(0u - static_cast<u32>(a)) : a / b; }
+	s32 Remainder(s32 a, s32 b) noexcept { return b == -1 ? 0 : a % b; }
+
+	// -1, 0 or 1, 2 if the values are unordered, which only happens for NaN.
+	template<class T>
+	s32 Compare(T a, T b) noexcept
+	{
+		return a < b ? -1 : a > b ? 1 : a == b ? 0 : 2;
+	}
+
+	f64 Bits(u64 value) noexcept
+	{
+		f64 result;
+		memcpy(&result, &value, sizeof(result));
+		return result;
+	}
+
+	/*
+	 * Accesses the linear memory at the unsigned value of an r register. Addresses behind the memory still lie
+	 * inside its reserved range and fault, so nothing has to be checked here.
+	**/
+	template<class T>
+	T Load(const char* memory, s32 address) noexcept
+	{
+		T value;
+		memcpy(&value, memory + static_cast<u32>(address), sizeof(value));
+		return value;
+	}
+
+	template<class T>
+	void Store(char* memory, s32 address, T value) noexcept
+	{
+		memcpy(memory + static_cast<u32>(address), &value, sizeof(value));
+	}
+};
 
 bool InterpreterContext::OpenFile(const std::string& path)
 {
-	std::fstream fStream(path, std::ios::binary | std::ios::in);
-	if (fStream.is_open())
+	Image image;
+	if (!image.Map(path)) return false;
+
+	if (Executable::IsNativeModule(image))
+	{
+		executable = Executable::OpenNative(path);
+		return executable != nullptr;
+	}
+	return Load(std::move(image));
+}
+
+bool InterpreterContext::Load(Image&& image)
+{
+	/*
+	 * A context that runs one binary after another keeps its executable, as long as no instance holds on to it.
+	**/
+	if (executable != nullptr && executable.use_count() == 1)
 	{
-		std::uintmax_t size = std::filesystem::file_size(path);
-		fileBytes.resize(size);
-		if (fileBytes.size() != size)
+		if (executable->Load(std::move(image))) return true;
+
+		executable.reset();
+		return false;
+	}
+
+	executable = Executable::Create(std::move(image));
+	return executable != nullptr;
+}
+
+std::uint32_t InterpreterContext::Execute(void)
+{
+	if (executable == nullptr)
+	{
+		std::cerr << "[ERROR] No virtual man binary has been loaded.\n";
+		return EXECUTION_FAILED;
+	}
+
+	executable->Fuse(fuse && !profile);
+
+	Instance instance(executable);
+	instance.SetDispatch(dispatch);
+	instance.SetPinRegisters(pinRegisters);
+	instance.SetProfiling(profile);
+	const std::uint32_t result = instance.Execute();
+
+	if (!instance.GetException().empty())
+	{
+		std::cerr << "[INTERNAL EXCEPTION] CODE EXECUTION HALTED. " << instance.GetException() << "\n";
+	}
+
+	if (profile) instance.GetProfiler()->Report(std::cout, executable->Code(), executable->Bytes());
+	return result;
+}
+
+Instance::Instance(std::shared_ptr<const Executable> program)
+	: executable(std::move(program))
+{
+}
+
+void Instance::SetProfiling(bool enable)
+{
+	if (!enable) profiler.reset();
+	else if (profiler == nullptr) profiler = std::make_unique<Profiler>();
+}
+
+std::uint32_t Instance::Execute(void)
+{
+	exception.clear();
+
+	const u32 pages = executable->Layout().memoryPages;
+	if ((pages != 0 || executable->Code().usesMemory) && (!Memory.Reserved() || Memory.Pages() != pages))
+	{
+		if (!Memory.Allocate(pages))
 		{
-			std::cerr << "[ERROR] Failed to allocate memory.\n";
-			return false;
+			std::cerr << "[ERROR] Failed to reserve the linear memory.\n";
+			return EXECUTION_FAILED;
 		}
+	}
+
+	if (!Memory.Reserved()) return Enter();
+
+	/*
+	 * The program gets abandoned on a fault, nothing the engines own at that point needs to be destroyed.
+	**/
+	std::uint32_t result = 0;
+	u64 address = 0;
+	if (!Memory.Guard([this, &result] { result = Enter(); }, address))
+	{
+		SetException("INVALID MEMORY ACCESS.", Operand::Address, 0, static_cast<s64>(address));
+		return EXECUTION_FAILED;
+	}
+	return result;
+}
+
+std::uint32_t Instance::Enter(void)
+{
+	// RaiseException lands here, the engines keep nothing that would have to be cleaned up.
+	if (setjmp(exceptionJump) != 0) return EXECUTION_FAILED;
+
+	const u32 entry = executable->Code().entry;
+
+	if (profiler != nullptr)
+	{
+		profiler->Reset(executable->Code().code.size());
+		return Interpret<true>(entry);
+	}
+
+	if (executable->Native() != nullptr) return RunNative();
+
+#if VMAN_JIT
+	if (dispatch == Dispatch::Jit) return RunJit();
+#endif
+
+	return Interpret<false>(entry);
+}
+
+template<bool Profile>
+std::uint32_t Instance::Interpret(u32 start)
+{
+#if VMAN_THREADED_DISPATCH
+	if (dispatch != Dispatch::Switch)
+	{
+		return pinRegisters ? Run<true, true, Profile>(start) : Run<true, false, Profile>(start);
+	}
+#endif
+	return pinRegisters ? Run<false, true, Profile>(start) : Run<false, false, Profile>(start);
+}
 
-		fStream.read(fileBytes.data(), size);
+void Instance::SetException(const char* message, Operand operand, u32 index, s64 value)
+{
+	exception = message;
+	switch (operand)
+	{
+		case Operand::Register: exception += "\n[REGISTER " + std::to_string(index) + "]: "; break;
+		case Operand::WideRegister: exception += "\n[REGISTER X" + std::to_string(index) + "]: "; break;
+		case Operand::Address: exception += "\n[ADDRESS]: "; break;
+	}
+	exception += std::to_string(value);
+}
+
+void Instance::RaiseException(const char* message, Operand operand, u32 index, s64 value)
+{
+	SetException(message, operand, index, value);
+	longjmp(exceptionJump, 1);
+}
+
+vman::vmb::Bridge& Instance::ThreadBridge(void)
+{
+	thread_local vmb::Bridge b;
+	return b;
+}
 
-		if (!fStream)
+void Instance::NativeCall(u32 site)
+{
+	vmb::Bridge& b = ThreadBridge();
+
+	const vmb::Bridge::CallPlan& plan = executable->Plan(site);
+	if (plan.caller == nullptr)
+	{
+		std::cerr << "[ERROR] Failed to perform native call.\n";
+		return;
+	}
+
+	/*
+	 * Imports have been resolved while loading, NFC takes the names from register 0 and 1.
+	**/
+	const CallSite& callSite = executable->Code().callSites[site];
+	const bool imported = site < executable->Code().imports;
+	const u32 library = imported ? callSite.library : static_cast<u32>(Registers[0]);
+	const u32 function = imported ? callSite.function : static_cast<u32>(Registers[1]);
+
+	void* funcPtr = imported ? executable->Import(site) : executable->ResolveNativeFunction(b, site, library, function);
+	if (funcPtr == nullptr)
+	{
+		SetResult({ 0, 0.0 });
+		return;
+	}
+
+	/*
+	 * Register 0 and 1 are reserved for library and function name,
+	 * the value of the n-th parameter is located at the address stored in register n + 2.
+	**/
+	char* image = WritableImage();
+	const void* values[MAX_NFC_PARAMS];
+	for (std::size_t i = 0; i < plan.pushers.size(); ++i)
+	{
+		const u8 type = callSite.paramTypes[i];
+		if (type & vmb::Bridge::VMBREGISTER)
+		{
+			const bool real = (type & ~vmb::Bridge::VMBREGISTER) == vmb::Bridge::VMBFLOAT || (type & ~vmb::Bridge::VMBREGISTER) == vmb::Bridge::VMBDOUBLE;
+			values[i] = real ? static_cast<const void*>(&FloatRegisters[i + 2]) : &WideRegisters[i + 2];
+			continue;
+		}
+
+		/*
+		 * The verifier couldn't prove that every value lies inside the binary, so each one is checked before the call.
+		**/
+		if (!callSite.verified && (Registers[i + 2] < 0 ||
+			static_cast<std::size_t>(Registers[i + 2]) + vmb::Bridge::ValueSize(callSite.paramTypes[i]) > ImageCopy.size()))
 		{
-			std::cerr << "[ERROR] Failed to read file.\n";
-			return false;
+			RaiseException("INVALID NATIVE CALL PARAMETER.", Operand::Register, static_cast<u32>(i + 2), Registers[i + 2]);
 		}
-		fStream.close();
-		return true;
+		values[i] = image + Registers[i + 2];
+	}
+
+	if (profiler != nullptr)
+	{
+		const u64 start = Profiler::Now();
+		SetResult(b.Call(plan, funcPtr, values));
+		profiler->RecordCall(library, function, Profiler::Now() - start);
+		return;
 	}
-	else std::cerr << "[ERROR] Failed to open file.\n";
-	return false;
+
+	SetResult(b.Call(plan, funcPtr, values));
 }
 
-std::uint32_t InterpreterContext::Execute(void)
+void Instance::SetResult(const vmb::Bridge::Result& result) noexcept
+{
+	Registers[2] = static_cast<s32>(result.integer);
+	WideRegisters[2] = result.integer;
+	FloatRegisters[2] = result.real;
+}
+
+void Instance::StepDivision(const Instruction& ins)
 {
-	vmb::Bridge b;
-	vmb::Bridge::Parameter params;
-	std::vector<vmb::Bridge::Parameter> vec;
-	LoadLibrary("User32.dll");
+	if (Registers[ins.c] == 0)
+	{
+		RaiseException("DIVISION BY ZERO ERROR.", Operand::Register, ins.c, Registers[ins.c]);
+	}
+	Registers[ins.a] = ins.opcode == DIV ? Divide(Registers[ins.b], Registers[ins.c]) : Remainder(Registers[ins.b], Registers[ins.c]);
+}
+
+void Instance::StepWide(const Instruction& ins)
+{
+	s64* x = WideRegisters.data();
+	f64* f = FloatRegisters.data();
+	const std::vector<u64>& constants = executable->Code().constants;
+
+	switch (ins.opcode)
+	{
+		case ADDX: x[ins.a] = Wrap(static_cast<u64>(x[ins.b]) + static_cast<u64>(x[ins.c])); break;
+		case SUBX: x[ins.a] = Wrap(static_cast<u64>(x[ins.b]) - static_cast<u64>(x[ins.c])); break;
+		case MULX: x[ins.a] = Wrap(static_cast<u64>(x[ins.b]) * static_cast<u64>(x[ins.c])); break;
+		case DIVX:
+		case MODX:
+			if (x[ins.c] == 0) RaiseException("DIVISION BY ZERO ERROR.", Operand::WideRegister, ins.c, 0);
+			x[ins.a] = ins.opcode == DIVX ? DivideWide(x[ins.b], x[ins.c]) : RemainderWide(x[ins.b], x[ins.c]);
+			break;
+		case LSHX: x[ins.a] = Wrap(static_cast<u64>(x[ins.b]) << (x[ins.c] & 63)); break;
+		case RSHX: x[ins.a] = x[ins.b] >> (x[ins.c] & 63); break;
+		case NOTX: x[ins.a] = ~x[ins.b]; break;
+		case ANDX: x[ins.a] = x[ins.b] & x[ins.c]; break;
+		case ORX: x[ins.a] = x[ins.b] | x[ins.c]; break;
+		case XORX: x[ins.a] = x[ins.b] ^ x[ins.c]; break;
+		case MOVX: x[ins.a] = static_cast<s64>(constants[ins.imm]); break;
+		case CMPX: Registers[ins.a] = Compare(x[ins.b], x[ins.c]); break;
+
+		case ADDF: f[ins.a] = f[ins.b] + f[ins.c]; break;
+		case SUBF: f[ins.a] = f[ins.b] - f[ins.c]; break;
+		case DIVF: f[ins.a] = f[ins.b] / f[ins.c]; break;
+		case MULF: f[ins.a] = f[ins.b] * f[ins.c]; break;
+		case MOVF: f[ins.a] = Bits(constants[ins.imm]); break;
+		case CMPF: Registers[ins.a] = Compare(f[ins.b], f[ins.c]); break;
+
+		case SEXT: x[ins.a] = Registers[ins.b]; break;
+		case TRUNC: Registers[ins.a] = static_cast<s32>(x[ins.b]); break;
+		case ITOF: f[ins.a] = static_cast<f64>(x[ins.b]); break;
+		case FTOI: x[ins.a] = vmb::Truncate(f[ins.b]); break;
+
+		case LOADX: x[ins.a] = Load<s64>(Memory.Data(), Registers[ins.b]); break;
+		case LOADF: f[ins.a] = Load<f64>(Memory.Data(), Registers[ins.b]); break;
+		case STOREX: Store(Memory.Data(), Registers[ins.a], x[ins.b]); break;
+		case STOREF: Store(Memory.Data(), Registers[ins.a], f[ins.b]); break;
+	}
+}
+
+char* Instance::WritableImage(void)
+{
+	if (ImageCopy.empty()) ImageCopy.assign(executable->Bytes().begin(), executable->Bytes().end());
+	return ImageCopy.data();
+}
+
+vman::vmb::Bridge::Result Instance::StepVector(const Instruction& ins, const s32* values)
+{
+	const u8 registers[] = { ins.a, ins.b, ins.c, static_cast<u8>(ins.imm) };
+	const s32 count = values[3];
+	if (count < 0) RaiseException("INVALID VECTOR LENGTH.", Operand::Register, registers[3], count);
+
 	/*
-	 * This is the program counter of the virtual machine.
+	 * Every buffer has to lie inside the binary. The result of a dot product goes into a register, so its first operand isn't a buffer.
 	**/
-	std::size_t PC;
+	char* image = WritableImage();
+	const bool dot = ins.opcode == VDOT || ins.opcode == VDOTF;
+	const u64 size = static_cast<u64>(count) * (ins.opcode >= VADDF ? sizeof(f64) : sizeof(s32));
+
+	for (std::size_t i = dot ? 1 : 0; i < 3; ++i)
+	{
+		if (values[i] < 0 || static_cast<u64>(values[i]) + size > ImageCopy.size()) RaiseException("INVALID VECTOR BUFFER.", Operand::Register, registers[i], values[i]);
+	}
+
+	// The result of partly overlapping buffers would depend on how many elements the kernel handles at once.
+	for (std::size_t i = 1; i < 3 && !dot; ++i)
+	{
+		const u64 distance = values[0] > values[i] ? static_cast<u64>(values[0] - values[i]) : static_cast<u64>(values[i] - values[0]);
+		if (distance != 0 && distance < size) RaiseException("OVERLAPPING VECTOR BUFFERS.", Operand::Register, registers[i], values[i]);
+	}
+
+	char* destination = image + values[0];
+	const char* a = image + values[1];
+	const char* b = image + values[2];
+
+	const VectorKernels& kernels = ActiveVectorKernels();
+	switch (ins.opcode)
+	{
+		case VADD: kernels.add(destination, a, b, count); break;
+		case VMUL: kernels.mul(destination, a, b, count); break;
+		case VMIN: kernels.min(destination, a, b, count); break;
+		case VMAX: kernels.max(destination, a, b, count); break;
+		case VCMP: kernels.compare(destination, a, b, count); break;
+		case VMASK: kernels.mask(destination, a, b, count); break;
+		case VDOT: return { kernels.dot(a, b, count), 0.0 };
 
+		case VADDF: kernels.addf(destination, a, b, count); break;
+		case VMULF: kernels.mulf(destination, a, b, count); break;
+		case VMINF: kernels.minf(destination, a, b, count); break;
+		case VMAXF: kernels.maxf(destination, a, b, count); break;
+		case VDOTF: return { 0, kernels.dotf(a, b, count) };
+	}
+	return { 0, 0.0 };
+}
+
+s32 Instance::StepMemory(u8 opcode, u32 first, u32 second, u32 count)
+{
 	/*
-	 * This variable stores the signature of a binary file and checks for compatibility.
+	 * The reserved range only covers a single page behind the memory, a longer range could reach other mappings
+	 * of the process, so every range gets compared against the size once. The reported address is the first one outside.
 	**/
-	std::size_t vmSignature;
-	memcpy(&PC, &fileBytes[0], sizeof(std::size_t));
-	memcpy(&vmSignature, &fileBytes[8], sizeof(std::size_t));
+	const u64 size = Memory.Size();
+	const auto check = [this, size, count](u32 address)
+	{
+		if (static_cast<u64>(address) + count > size) RaiseException("INVALID MEMORY ACCESS.", Operand::Address, 0, static_cast<s64>(std::max<u64>(address, size)));
+	};
+
+	check(first);
+	if (opcode != MEMSET) check(second);
 
 	/*
-	 * Virtual man checks here if the given binary file has the 1911 KUQEZI signature, 
-	 * if virtual man can't detect this signature, it will refuse to disassemble or execute the binary.
+	 * The C runtime picks implementations for the instruction sets of the CPU, they run at the bandwidth of the memory.
 	**/
+	char* memory = Memory.Data();
+	switch (opcode)
+	{
+		case MEMCPY: memmove(memory + first, memory + second, count); break;
+		case MEMSET: memset(memory + first, static_cast<u8>(second), count); break;
+		case MEMCMP: return Compare(memcmp(memory + first, memory + second, count), 0);
+	}
+	return 0;
+}
+
+/*
+ * A compiled program keeps its registers in local variables and only calls back for NFC and errors,
+ * the registers of the instance are written when the program ends.
+**/
+std::uint32_t Instance::RunNative(void)
+{
+	const NativeHost host = { this, executable->Imports(), Memory.Data(), &NativeResolve, &NativeDynamicCall, &NativeVector, &NativeRaise };
 
-	if (vmSignature != 0x495A4551554B1119)
+	// Native functions are allowed to write into the data section, they receive pointers into the copy of the instance.
+	return static_cast<std::uint32_t>(executable->Native()(Registers.data(), WideRegisters.data(), FloatRegisters.data(), WritableImage(), &host));
+}
+
+void* Instance::NativeResolve(void* context, u32 site, u32 library, u32 function)
+{
+	const Instance* instance = static_cast<const Instance*>(context);
+	return instance->executable->ResolveNativeFunction(ThreadBridge(), site, library, function);
+}
+
+vman::vmb::Bridge::Result Instance::NativeDynamicCall(void* context, u32 site, void* function, const void* const* values)
+{
+	const Instance* instance = static_cast<const Instance*>(context);
+
+	const vmb::Bridge::CallPlan& plan = instance->executable->Plan(site);
+	if (plan.caller == nullptr)
 	{
-		std::cerr << "[ERROR] This is not a compatible virtual man binary.\n";
-		return 0x777;
+		std::cerr << "[ERROR] Failed to perform native call.\n";
+		return { 0, 0.0 };
 	}
+	return ThreadBridge().Call(plan, function, values);
+}
+
+vman::vmb::Bridge::Result Instance::NativeVector(void* context, u32 index, const s32* values)
+{
+	Instance* instance = static_cast<Instance*>(context);
+	const Instruction& ins = instance->executable->Code().code[index];
 
-	for (; PC < fileBytes.size(); PC++)
+	if (ins.opcode == MEMCMP) return { instance->StepMemory(ins.opcode, values[1], values[2], values[3]), 0.0 };
+	if (IsBulkMemory(ins.opcode)) return { instance->StepMemory(ins.opcode, values[0], values[1], values[2]), 0.0 };
+	return instance->StepVector(ins, values);
+}
+
+void Instance::NativeRaise(void* context, s32 error, s32 reg, s64 value)
+{
+	Instance* instance = static_cast<Instance*>(context);
+	const u32 index = static_cast<u32>(reg);
+	switch (error)
 	{
-		switch (fileBytes[PC])
+		case NATIVE_DIVISION_BY_ZERO: instance->RaiseException("DIVISION BY ZERO ERROR.", Operand::Register, index, value);
+		case NATIVE_WIDE_DIVISION_BY_ZERO: instance->RaiseException("DIVISION BY ZERO ERROR.", Operand::WideRegister, index, value);
+		case NATIVE_INVALID_JUMP: instance->RaiseException("INVALID JUMP TARGET.", Operand::Register, index, value);
+		default: instance->RaiseException("INVALID NATIVE CALL PARAMETER.", Operand::Register, index, value);
+	}
+}
+
+/*
+ * The JIT runs every block natively and only returns to the interpreter for native calls and HALT.
+ * All virtual registers are kept in memory by the compiled code, so both can work with the same registers.
+**/
+std::uint32_t Instance::RunJit(void)
+{
+	const Program& program = executable->Code();
+
+	if (!executable->CompileJit())
+	{
+		std::cerr << "[ERROR] Failed to compile the program, falling back to the interpreter.\n";
+		return Run<false, false, false>(program.entry);
+	}
+
+	u32 index = program.entry;
+
+	for (;;)
+	{
+		const Instruction& ins = program.code[index];
+
+		if (ins.opcode == HALT)
+		{
+			return 0;
+		}
+		else if (ins.opcode == NFC || ins.opcode == NFCI)
+		{
+			NativeCall(ins.imm);
+			++index;
+			continue;
+		}
+		else if (IsVector(ins.opcode))
 		{
-			case NOP: // NOP DOES NOTHING AND JUST SKIPS.
-				break;
+			const s32 values[] = { Registers[ins.a], Registers[ins.b], Registers[ins.c], Registers[ins.imm] };
+			const vmb::Bridge::Result result = StepVector(ins, values);
 
-			case NFC:
-			{
-				#pragma warning ( push )
-				#pragma warning ( disable : 6263 )
-				#pragma warning ( disable :  6387)
-
-				/*
-				 * Either allocates memory on the stack or the heap.
-				 * Chosen by the runtime.
-				**/
-				char* funcName = static_cast<CSTR>(_malloca(64));
-				char* libName = static_cast<CSTR>(_malloca(128));
-
-				memset(funcName, 0, 64);
-				memset(libName, 0, 128);
-
-				/*
-				 * Copy the ascii representation of the library and function name inside the array
-				 * strncpy automatically stops execution after hitting a \0 or if the pointer index
-				 * exceeds the maximum sizes.
-				**/
-				strncpy(libName, &fileBytes[Registers[0]], 128);
-				strncpy(funcName, &fileBytes[Registers[1]], 64);
-
-				/*
-				 * Perhaps a stupid name for this variable, anyways,
-				 * in the binary stream, VirtualMAN reserves the first and second index (i + 0 and i + 1) for the opcode and return type
-				 * Register 0 and 1 are reserved for library and function name.
-				 *
-				**/
-				size_t regIndex = 2;
-
-				/*
-				 * Tokenize each parameter for the function passing.
-				**/
-				while (fileBytes[PC + regIndex])
-				{
-					params.paramType = fileBytes[PC + regIndex];
-					params.value = &fileBytes[Registers[regIndex]];
-					vec.push_back(params);
-					regIndex++;
-				}
-				switch (fileBytes[PC + 1])
-				{
-				case vmb::Bridge::VMBCHAR: 
-				{ 
-					Registers[2] = static_cast<s32>(b.CallNativeFunction<char>(libName, funcName, vec));
-				} break;
-
-				case vmb::Bridge::VMBBOOL: 
-				{ 
-					Registers[2] = static_cast<s32>(b.CallNativeFunction<bool>(libName, funcName, vec));
-				} break;
-
-				case vmb::Bridge::VMBSHORT: 
-				{ 
-					Registers[2] = static_cast<s32>(b.CallNativeFunction<short>(libName, funcName, vec));
-				} break;
-
-				case vmb::Bridge::VMBINT: 
-				{ 
-					Registers[2] = static_cast<s32>(b.CallNativeFunction<int>(libName, funcName, vec));
-				} break;
-
-				case vmb::Bridge::VMBLONG: 
-				{
-					Registers[2] = static_cast<s32>(b.CallNativeFunction<long>(libName, funcName, vec));
-				} break;
-
-				case vmb::Bridge::VMBLONG_LONG: 
-				{ 
-					Registers[2] = static_cast<s32>(b.CallNativeFunction<long long>(libName, funcName, vec));
-				} break;
-
-				case vmb::Bridge::VMBFLOAT: 
-				{ 
-					Registers[2] = static_cast<s32>(b.CallNativeFunction<float>(libName, funcName, vec));
-				} break;
-				case vmb::Bridge::VMBDOUBLE: 
-				{ 
-					Registers[2] = static_cast<s32>(b.CallNativeFunction<double>(libName, funcName, vec));
-				} break;
-
-				default: { std::cerr << "[ERROR] Failed to perform native call.\n"; } break;
-
-				#pragma warning ( pop )
-				}
-
-				PC += regIndex + 1;
-				_freea(funcName);
-				_freea(libName);
-			}
-			
-			break;
+			if (ins.opcode == VDOT) Registers[ins.a] = static_cast<s32>(result.integer);
+			else if (ins.opcode == VDOTF) FloatRegisters[ins.a] = result.real;
+			++index;
+			continue;
+		}
+		else if (IsBulkMemory(ins.opcode))
+		{
+			if (ins.opcode == MEMCMP) Registers[ins.a] = StepMemory(MEMCMP, Registers[ins.b], Registers[ins.c], Registers[ins.imm]);
+			else StepMemory(ins.opcode, Registers[ins.a], Registers[ins.b], Registers[ins.c]);
+			++index;
+			continue;
+		}
+		else if (UsesWideRegisters(ins.opcode))
+		{
+			StepWide(ins);
+			++index;
+			continue;
+		}
 
-			case MOV:
-			{
-				s32 movValue;
+		JitBlock block = executable->Block(index);
+		if (block == nullptr)
+		{
+			std::cerr << "[ERROR] Failed to compile the program, falling back to the interpreter.\n";
+			return Run<false, false, false>(index);
+		}
 
-				// Directly converts a big endian encoded byte array
-				movValue = ((fileBytes[PC + 6] << 0) | (fileBytes[PC + 5] << 8) | (fileBytes[PC + 4] << 16) | (fileBytes[PC + 3] << 24)) / 0x100;
-				Registers[fileBytes[PC + 1]] = movValue;
-				PC += 5;
-			}
-			break;
+		const u64 result = block(Registers.data(), Memory.Data());
+		const u32 address = static_cast<u32>(result);
 
-			case ADD:
-			{
-				Registers[fileBytes[PC + 1]] = Registers[fileBytes[PC + 2]] + Registers[fileBytes[PC + 3]];
-				PC += 3;
-			}
-			break;
+		index = program.IndexOf(address);
 
-			case SUB:
-			{
-				Registers[fileBytes[PC + 1]] = Registers[fileBytes[PC + 2]] - Registers[fileBytes[PC + 3]];
-				PC += 3;
-			}
-			break;
+		if (result & JIT_BAILOUT)
+		{
+			// Only a division by zero or -1 leaves a block early, the interpreter checks the divisor.
+			StepDivision(program.code[index]);
+			++index;
+		}
+		else if (index == INVALID_INDEX)
+		{
+			RaiseException("INVALID JUMP TARGET.", Operand::Address, 0, address);
+		}
+	}
+}
+
+/*
+ * Both dispatch modes share the same handlers, the handlers only differ in the way they reach the next one.
+ * With switch dispatch every handler jumps back to the switch statement, which means that all instructions
+ * share a single indirect branch. Threaded dispatch ends each handler with its own indirect branch to the
+ * next handler, which gives the branch predictor of the CPU a lot more context.
+**/
+#define VMAN_CASE(op) case op: op_##op
+
+/*
+ * Every handler has a label for threaded dispatch, switch dispatch doesn't need them.
+**/
+#if defined (__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-label"
+#endif
+
+#define VMAN_REG(x) (Pinned ? pinned[x] : Registers[x])
+#define VMAN_SPILL() do { if constexpr (Pinned) std::copy(pinned, pinned + 12, Registers.begin()); } while (0)
+#define VMAN_RELOAD() do { if constexpr (Pinned) std::copy(Registers.begin(), Registers.end(), pinned); } while (0)
+
+#define VMAN_PROFILE() do { if constexpr (Profile) profiler->Record(ip->opcode, static_cast<u32>(ip - code)); } while (0)
+
+#if VMAN_THREADED_DISPATCH
+#define VMAN_NEXT() do { VMAN_PROFILE(); if constexpr (Threaded) { goto *threaded[ip - code]; } else { goto dispatch; } } while (0)
+#else
+#define VMAN_NEXT() do { VMAN_PROFILE(); goto dispatch; } while (0)
+#endif
+
+template<bool Threaded, bool Pinned, bool Profile>
+std::uint32_t Instance::Run(u32 start)
+{
+	/*
+	 * With pinned registers, the loop works on a local copy of the registers. Its address never leaves this function,
+	 * so the compiler doesn't have to reload the registers through this after every store and can keep them in host registers.
+	 * The copy is written back before the registers become visible to anything else: NFC, exceptions and the end of the program.
+	**/
+	s32 pinned[12];
+	if constexpr (Pinned) std::copy(Registers.begin(), Registers.end(), pinned);
+
+	const Program& program = executable->Code();
+	const Instruction* const code = program.code.data();
+	const u64* const constants = program.constants.data();
+
+	// The x and f registers always stay in memory, only the r registers are pinned.
+	s64* const x = WideRegisters.data();
+	f64* const f = FloatRegisters.data();
+
+	char* const memory = Memory.Data();
+
+#if VMAN_THREADED_DISPATCH
+	const void* const* threaded = nullptr;
+	if constexpr (Threaded)
+	{
+		/*
+		 * The decoder only emits known opcodes, everything else has been turned into a NOP.
+		**/
+		const void* labels[256] = {};
+		labels[HALT] = &&op_HALT;
+		labels[NOP] = &&op_NOP;
+		labels[NFC] = &&op_NFC;
+		labels[NFCI] = &&op_NFCI;
+		labels[MOV] = &&op_MOV;
+		labels[ADD] = &&op_ADD;
+		labels[SUB] = &&op_SUB;
+		labels[DIV] = &&op_DIV;
+		labels[MUL] = &&op_MUL;
+		labels[MOD] = &&op_MOD;
+		labels[LSH] = &&op_LSH;
+		labels[RSH] = &&op_RSH;
+		labels[AND] = &&op_AND;
+		labels[OR] = &&op_OR;
+		labels[XOR] = &&op_XOR;
+		labels[NOT] = &&op_NOT;
+		labels[JMP] = &&op_JMP;
+		labels[JIE] = &&op_JIE;
+		labels[JNE] = &&op_JNE;
+		labels[MOV_MOV] = &&op_MOV_MOV;
+		labels[MOV_ADD] = &&op_MOV_ADD;
+		labels[SUB_JNE] = &&op_SUB_JNE;
+		labels[ADD_JNE] = &&op_ADD_JNE;
+		labels[ADDX] = &&op_ADDX;
+		labels[SUBX] = &&op_SUBX;
+		labels[DIVX] = &&op_DIVX;
+		labels[MULX] = &&op_MULX;
+		labels[MODX] = &&op_MODX;
+		labels[LSHX] = &&op_LSHX;
+		labels[RSHX] = &&op_RSHX;
+		labels[NOTX] = &&op_NOTX;
+		labels[ANDX] = &&op_ANDX;
+		labels[ORX] = &&op_ORX;
+		labels[XORX] = &&op_XORX;
+		labels[MOVX] = &&op_MOVX;
+		labels[CMPX] = &&op_CMPX;
+		labels[ADDF] = &&op_ADDF;
+		labels[SUBF] = &&op_SUBF;
+		labels[DIVF] = &&op_DIVF;
+		labels[MULF] = &&op_MULF;
+		labels[MOVF] = &&op_MOVF;
+		labels[CMPF] = &&op_CMPF;
+		labels[SEXT] = &&op_SEXT;
+		labels[TRUNC] = &&op_TRUNC;
+		labels[ITOF] = &&op_ITOF;
+		labels[FTOI] = &&op_FTOI;
+		labels[VADD] = &&op_VADD;
+		labels[VMUL] = &&op_VMUL;
+		labels[VMIN] = &&op_VMIN;
+		labels[VMAX] = &&op_VMAX;
+		labels[VDOT] = &&op_VDOT;
+		labels[VCMP] = &&op_VCMP;
+		labels[VMASK] = &&op_VMASK;
+		labels[VADDF] = &&op_VADDF;
+		labels[VMULF] = &&op_VMULF;
+		labels[VMINF] = &&op_VMINF;
+		labels[VMAXF] = &&op_VMAXF;
+		labels[VDOTF] = &&op_VDOTF;
+		labels[LOAD8] = &&op_LOAD8;
+		labels[LOAD8S] = &&op_LOAD8S;
+		labels[LOAD16] = &&op_LOAD16;
+		labels[LOAD16S] = &&op_LOAD16S;
+		labels[LOAD32] = &&op_LOAD32;
+		labels[LOADX] = &&op_LOADX;
+		labels[LOADF] = &&op_LOADF;
+		labels[STORE8] = &&op_STORE8;
+		labels[STORE16] = &&op_STORE16;
+		labels[STORE32] = &&op_STORE32;
+		labels[STOREX] = &&op_STOREX;
+		labels[STOREF] = &&op_STOREF;
+		labels[MEMCPY] = &&op_MEMCPY;
+		labels[MEMSET] = &&op_MEMSET;
+		labels[MEMCMP] = &&op_MEMCMP;
+
+		// Each instantiation of Run has its own handlers, so each one uses its own table.
+		threaded = executable->ThreadedCode((Pinned ? 2 : 0) + (Profile ? 1 : 0), labels);
+	}
+#endif
+
+	/*
+	 * Points to the instruction that is currently executed, this replaces the byte based program counter.
+	**/
+	const Instruction* ip = &code[start];
+
+	/*
+	 * Holds the register with the target address for JMP, JIE and JNE.
+	**/
+	u8 target;
+
+	VMAN_PROFILE();
+
+dispatch:
+	switch (ip->opcode)
+	{
+		VMAN_CASE(HALT):
+			VMAN_SPILL();
+			return 0;
+
+		default:
+		VMAN_CASE(NOP): // NOP DOES NOTHING AND JUST SKIPS.
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(NFC):
+		VMAN_CASE(NFCI):
+			VMAN_SPILL();
+			NativeCall(ip->imm);
+			VMAN_RELOAD();
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(MOV):
+			VMAN_REG(ip->a) = ip->imm;
+			++ip;
+			VMAN_NEXT();
 
-			case DIV:
+		VMAN_CASE(ADD):
+			VMAN_REG(ip->a) = Wrap(static_cast<u32>(VMAN_REG(ip->b)) + static_cast<u32>(VMAN_REG(ip->c)));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(SUB):
+			VMAN_REG(ip->a) = Wrap(static_cast<u32>(VMAN_REG(ip->b)) - static_cast<u32>(VMAN_REG(ip->c)));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(DIV):
+			if (VMAN_REG(ip->c) == 0)
 			{
-				if (Registers[fileBytes[PC + 3]] == 0)
-				{
-					std::cerr << "[INTERNAL EXCEPTION] CODE EXECUTION HALTED. DIVISION BY ZERO ERROR.\n";
-					std::cerr << "[REGISTER " << fileBytes[PC + 3] << "]: " << Registers[fileBytes[PC + 3]] << "\n";
-					while (!getchar());
-					exit(-1);
-				}
-				else
-				{
-					Registers[fileBytes[PC + 1]] = Registers[fileBytes[PC + 2]] / Registers[fileBytes[PC + 3]];
-					PC += 3;
-				}
+				VMAN_SPILL();
+				RaiseException("DIVISION BY ZERO ERROR.", Operand::Register, ip->c, VMAN_REG(ip->c));
 			}
-			break;
+			VMAN_REG(ip->a) = Divide(VMAN_REG(ip->b), VMAN_REG(ip->c));
+			++ip;
+			VMAN_NEXT();
 
-			case MUL:
+		VMAN_CASE(MUL):
+			VMAN_REG(ip->a) = Wrap(static_cast<u32>(VMAN_REG(ip->b)) * static_cast<u32>(VMAN_REG(ip->c)));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(MOD):
+			if (VMAN_REG(ip->c) == 0)
 			{
-				Registers[fileBytes[PC + 1]] = Registers[fileBytes[PC + 2]] * Registers[fileBytes[PC + 3]];
-				PC += 3;
+				VMAN_SPILL();
+				RaiseException("DIVISION BY ZERO ERROR.", Operand::Register, ip->c, VMAN_REG(ip->c));
 			}
-			break;
+			VMAN_REG(ip->a) = Remainder(VMAN_REG(ip->b), VMAN_REG(ip->c));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(LSH):
+			VMAN_REG(ip->a) = Wrap(static_cast<u32>(VMAN_REG(ip->b)) << (VMAN_REG(ip->c) & 31));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(RSH):
+			VMAN_REG(ip->a) = VMAN_REG(ip->b) >> (VMAN_REG(ip->c) & 31);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(AND):
+			VMAN_REG(ip->a) = VMAN_REG(ip->b) & VMAN_REG(ip->c);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(OR):
+			VMAN_REG(ip->a) = VMAN_REG(ip->b) | VMAN_REG(ip->c);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(XOR):
+			VMAN_REG(ip->a) = VMAN_REG(ip->b) ^ VMAN_REG(ip->c);
+			++ip;
+			VMAN_NEXT();
 
-			case MOD:
+		VMAN_CASE(NOT):
+			VMAN_REG(ip->a) = ~VMAN_REG(ip->b);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(JMP):
+			target = ip->a;
+			goto jump;
+
+		VMAN_CASE(JIE):
+			if (VMAN_REG(ip->a) != VMAN_REG(ip->b))
 			{
-				Registers[fileBytes[PC + 1]] = Registers[fileBytes[PC + 2]] % Registers[fileBytes[PC + 3]];
-				PC += 3;
+				++ip;
+				VMAN_NEXT();
 			}
-			break;
+			target = ip->c;
+			goto jump;
 
-			case LSH:
+		VMAN_CASE(JNE):
+			if (VMAN_REG(ip->a) == VMAN_REG(ip->b))
 			{
-				Registers[fileBytes[PC + 1]] = Registers[fileBytes[PC + 2]] << Registers[fileBytes[PC + 3]];
-				PC += 3;
+				++ip;
+				VMAN_NEXT();
 			}
-			break;
+			target = ip->c;
+			goto jump;
+
+		VMAN_CASE(ADDX):
+			x[ip->a] = Wrap(static_cast<u64>(x[ip->b]) + static_cast<u64>(x[ip->c]));
+			++ip;
+			VMAN_NEXT();
 
-			case RSH:
+		VMAN_CASE(SUBX):
+			x[ip->a] = Wrap(static_cast<u64>(x[ip->b]) - static_cast<u64>(x[ip->c]));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(DIVX):
+			if (x[ip->c] == 0)
 			{
-				Registers[fileBytes[PC + 1]] = Registers[fileBytes[PC + 2]] >> Registers[fileBytes[PC + 3]];
-				PC += 3;
+				VMAN_SPILL();
+				RaiseException("DIVISION BY ZERO ERROR.", Operand::WideRegister, ip->c, 0);
 			}
-			break;
+			x[ip->a] = DivideWide(x[ip->b], x[ip->c]);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(MULX):
+			x[ip->a] = Wrap(static_cast<u64>(x[ip->b]) * static_cast<u64>(x[ip->c]));
+			++ip;
+			VMAN_NEXT();
 
-			case AND:
+		VMAN_CASE(MODX):
+			if (x[ip->c] == 0)
 			{
-				Registers[fileBytes[PC + 1]] = Registers[fileBytes[PC + 2]] & Registers[fileBytes[PC + 3]];
-				PC += 3;
+				VMAN_SPILL();
+				RaiseException("DIVISION BY ZERO ERROR.", Operand::WideRegister, ip->c, 0);
 			}
-			break;
+			x[ip->a] = RemainderWide(x[ip->b], x[ip->c]);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(LSHX):
+			x[ip->a] = Wrap(static_cast<u64>(x[ip->b]) << (x[ip->c] & 63));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(RSHX):
+			x[ip->a] = x[ip->b] >> (x[ip->c] & 63);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(NOTX):
+			x[ip->a] = ~x[ip->b];
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(ANDX):
+			x[ip->a] = x[ip->b] & x[ip->c];
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(ORX):
+			x[ip->a] = x[ip->b] | x[ip->c];
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(XORX):
+			x[ip->a] = x[ip->b] ^ x[ip->c];
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(MOVX):
+			x[ip->a] = static_cast<s64>(constants[ip->imm]);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(CMPX):
+			VMAN_REG(ip->a) = Compare(x[ip->b], x[ip->c]);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(ADDF):
+			f[ip->a] = f[ip->b] + f[ip->c];
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(SUBF):
+			f[ip->a] = f[ip->b] - f[ip->c];
+			++ip;
+			VMAN_NEXT();
 
-			case OR:
+		VMAN_CASE(DIVF):
+			f[ip->a] = f[ip->b] / f[ip->c];
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(MULF):
+			f[ip->a] = f[ip->b] * f[ip->c];
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(MOVF):
+			f[ip->a] = Bits(constants[ip->imm]);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(CMPF):
+			VMAN_REG(ip->a) = Compare(f[ip->b], f[ip->c]);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(SEXT):
+			x[ip->a] = VMAN_REG(ip->b);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(TRUNC):
+			VMAN_REG(ip->a) = static_cast<s32>(x[ip->b]);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(ITOF):
+			f[ip->a] = static_cast<f64>(x[ip->b]);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(FTOI):
+			x[ip->a] = vmb::Truncate(f[ip->b]);
+			++ip;
+			VMAN_NEXT();
+
+		/*
+		 * The vector instructions share one handler, the work happens in the kernels anyway.
+		**/
+		VMAN_CASE(VADD):
+		VMAN_CASE(VMUL):
+		VMAN_CASE(VMIN):
+		VMAN_CASE(VMAX):
+		VMAN_CASE(VDOT):
+		VMAN_CASE(VCMP):
+		VMAN_CASE(VMASK):
+		VMAN_CASE(VADDF):
+		VMAN_CASE(VMULF):
+		VMAN_CASE(VMINF):
+		VMAN_CASE(VMAXF):
+		VMAN_CASE(VDOTF):
+		{
+			const s32 values[] = { VMAN_REG(ip->a), VMAN_REG(ip->b), VMAN_REG(ip->c), VMAN_REG(ip->imm) };
+			const vmb::Bridge::Result result = StepVector(*ip, values);
+
+			if (ip->opcode == VDOT) VMAN_REG(ip->a) = static_cast<s32>(result.integer);
+			else if (ip->opcode == VDOTF) f[ip->a] = result.real;
+			++ip;
+			VMAN_NEXT();
+		}
+
+		VMAN_CASE(LOAD8):
+			VMAN_REG(ip->a) = Load<u8>(memory, VMAN_REG(ip->b));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(LOAD8S):
+			VMAN_REG(ip->a) = Load<s8>(memory, VMAN_REG(ip->b));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(LOAD16):
+			VMAN_REG(ip->a) = Load<u16>(memory, VMAN_REG(ip->b));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(LOAD16S):
+			VMAN_REG(ip->a) = Load<s16>(memory, VMAN_REG(ip->b));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(LOAD32):
+			VMAN_REG(ip->a) = Load<s32>(memory, VMAN_REG(ip->b));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(LOADX):
+			x[ip->a] = Load<s64>(memory, VMAN_REG(ip->b));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(LOADF):
+			f[ip->a] = Load<f64>(memory, VMAN_REG(ip->b));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(STORE8):
+			Store(memory, VMAN_REG(ip->a), static_cast<u8>(VMAN_REG(ip->b)));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(STORE16):
+			Store(memory, VMAN_REG(ip->a), static_cast<u16>(VMAN_REG(ip->b)));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(STORE32):
+			Store(memory, VMAN_REG(ip->a), VMAN_REG(ip->b));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(STOREX):
+			Store(memory, VMAN_REG(ip->a), x[ip->b]);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(STOREF):
+			Store(memory, VMAN_REG(ip->a), f[ip->b]);
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(MEMCPY):
+		VMAN_CASE(MEMSET):
+			StepMemory(ip->opcode, VMAN_REG(ip->a), VMAN_REG(ip->b), VMAN_REG(ip->c));
+			++ip;
+			VMAN_NEXT();
+
+		VMAN_CASE(MEMCMP):
+			VMAN_REG(ip->a) = StepMemory(MEMCMP, VMAN_REG(ip->b), VMAN_REG(ip->c), VMAN_REG(ip->imm));
+			++ip;
+			VMAN_NEXT();
+
+		/*
+		 * Superinstructions execute two instructions with a single dispatch,
+		 * the operands of the second one are taken from the instruction that follows.
+		**/
+		VMAN_CASE(MOV_MOV):
+			VMAN_REG(ip[0].a) = ip[0].imm;
+			VMAN_REG(ip[1].a) = ip[1].imm;
+			ip += 2;
+			VMAN_NEXT();
+
+		VMAN_CASE(MOV_ADD):
+			VMAN_REG(ip[0].a) = ip[0].imm;
+			VMAN_REG(ip[1].a) = Wrap(static_cast<u32>(VMAN_REG(ip[1].b)) + static_cast<u32>(VMAN_REG(ip[1].c)));
+			ip += 2;
+			VMAN_NEXT();
+
+		VMAN_CASE(SUB_JNE):
+			VMAN_REG(ip->a) = Wrap(static_cast<u32>(VMAN_REG(ip->b)) - static_cast<u32>(VMAN_REG(ip->c)));
+			++ip;
+			if (VMAN_REG(ip->a) == VMAN_REG(ip->b))
 			{
-				Registers[fileBytes[PC + 1]] = Registers[fileBytes[PC + 2]] | Registers[fileBytes[PC + 3]];
-				PC += 3;
+				++ip;
+				VMAN_NEXT();
 			}
-			break;
+			target = ip->c;
+			goto jump;
 
-			case XOR:
+		VMAN_CASE(ADD_JNE):
+			VMAN_REG(ip->a) = Wrap(static_cast<u32>(VMAN_REG(ip->b)) + static_cast<u32>(VMAN_REG(ip->c)));
+			++ip;
+			if (VMAN_REG(ip->a) == VMAN_REG(ip->b))
 			{
-				Registers[fileBytes[PC + 1]] = Registers[fileBytes[PC + 2]] ^ Registers[fileBytes[PC + 3]];
-				PC += 3;
+				++ip;
+				VMAN_NEXT();
 			}
-			break;
+			target = ip->c;
+			goto jump;
+	}
 
-			case NOT:
+jump:
+	{
+		/*
+		 * Targets the verifier resolved are taken as they are. Any other target address is only known at runtime,
+		 * the program translates it to an instruction.
+		**/
+		u32 index = static_cast<u32>(ip->imm);
+		if (index == INVALID_INDEX)
+		{
+			index = program.IndexOf(static_cast<u32>(VMAN_REG(target)));
+			if (index == INVALID_INDEX)
 			{
-				Registers[fileBytes[PC + 1]] = ~Registers[fileBytes[PC + 2]];
-				PC += 2;
+				VMAN_SPILL();
+				RaiseException("INVALID JUMP TARGET.", Operand::Register, target, VMAN_REG(target));
 			}
-			break;
-
-			case JMP:
-				PC = Registers[fileBytes[PC + 1]];
-				break;
-
-			case JIE:
-				if (Registers[fileBytes[PC + 1]] == Registers[PC + 2])
-				{
-					PC = Registers[fileBytes[PC + 3]];
-				}
-				PC += 3;
-				break;
-
-			case JNE:
-				if (Registers[fileBytes[PC + 1]] != Registers[PC + 2])
-				{
-					PC = Registers[fileBytes[PC + 3]];
-				}
-				PC += 3;
-				break;
 		}
+		ip = &code[index];
 	}
-	return 0;
+	VMAN_NEXT();
 }
+
+#if defined (__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+#undef VMAN_CASE
+#undef VMAN_NEXT
+#undef VMAN_REG
+#undef VMAN_SPILL
+#undef VMAN_RELOAD
+#undef VMAN_PROFILE
\ No newline at end of file
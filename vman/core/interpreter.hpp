@@ -26,24 +26,87 @@
 #include <array>
 #include <string>
 #include <vector>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <filesystem>
 
 #include "core.hpp"
 #include "opcodes.hpp"
+#include "decoder.hpp"
+#include "executable.hpp"
+#include "profiler.hpp"
+#include "vector.hpp"
+#include "memory.hpp"
 #include "../vmb/vmb.hpp"
 
+/*
+ * Threaded dispatch relies on the labels as values extension of GCC and Clang.
+ * Define VMAN_THREADED_DISPATCH as 0 to only build the portable switch dispatch.
+**/
+#if !defined (VMAN_THREADED_DISPATCH)
+#if defined (__GNUC__)
+#define VMAN_THREADED_DISPATCH 1
+#else
+#define VMAN_THREADED_DISPATCH 0
+#endif
+#endif
+
 namespace vman::core
 {
-	class InterpreterContext
+	/*
+	 * Decides how the interpreter jumps from one instruction handler to the next one.
+	 * Switch uses a single switch statement, Threaded jumps from each handler directly to the next handler.
+	 * If the compiler doesn't support threaded dispatch, Threaded falls back to Switch.
+	 * Jit translates basic blocks into x86-64 machine code and only interprets NFC, on other targets it falls back to Threaded.
+	**/
+	enum class Dispatch
+	{
+		Switch,
+		Threaded,
+		Jit
+	};
+
+	/*
+	 * Returned by Execute if the program couldn't be run or has been stopped by an exception.
+	**/
+	constexpr const std::uint32_t EXECUTION_FAILED = 0x777;
+
+	// What the detail of an exception refers to.
+	enum class Operand : u8
+	{
+		Register,
+		WideRegister,
+		Address
+	};
+
+	/*
+	 * A single virtual machine that runs an executable. All it owns are its registers and the way it runs,
+	 * the code, the symbol cache and the compiled blocks belong to the executable.
+	 * This makes instances cheap enough to create one for every request.
+	 * An instance runs on one thread at a time, different instances can run on different threads.
+	**/
+	class Instance
 	{
 	private:
+		std::shared_ptr<const Executable> executable;
+
+		Dispatch dispatch = VMAN_THREADED_DISPATCH ? Dispatch::Threaded : Dispatch::Switch;
+
+		/*
+		 * Keeps the registers in local variables of the interpreter loop instead of accessing them through this,
+		 * they are only written back for NFC, exceptions and the end of the program.
+		**/
+		bool pinRegisters = true;
+
 		/*
-		 * During startup, virtual man reads an ifstream and copies each byte into this vector.
-		 * VirtualMAN handles code through memory IO rather than file IO.
+		 * Records the executed opcode pairs and prints them when the program ends,
+		 * it only gets allocated if profiling has been enabled.
 		**/
-		std::vector<char> fileBytes;
+		std::unique_ptr<Profiler> profiler;
 
 		/*
 		 * This array defines the virtual registers that are used by virtual man
@@ -52,8 +115,178 @@ namespace vman::core
 		 */
 		std::array<s32, 12> Registers = {};
 
+		/*
+		 * The 64 bit integer registers x0 to x11 and the double registers f0 to f11. Only the opcodes of their banks
+		 * and NFC use them, NFC passes parameters of a register type from them and writes its result into x2 and f2.
+		**/
+		std::array<s64, 12> WideRegisters = {};
+		std::array<f64, 12> FloatRegisters = {};
+
+		/*
+		 * Reserved on the first run of a program that loads or stores or whose binary asks for memory,
+		 * it keeps its content between runs like the registers do.
+		**/
+		LinearMemory Memory;
+
+		/*
+		 * The binary as this instance sees it. Native functions and the vector instructions write into buffers of the binary,
+		 * the image of the executable is shared by every instance, so each one works on its own copy.
+		 * It is made on the first native call or vector instruction and kept between runs like the registers.
+		**/
+		std::vector<char> ImageCopy;
+
+		/*
+		 * The error that stopped the last run, empty if it ended normally.
+		 * RaiseException jumps back to Enter through exceptionJump, which ends the run of this instance only.
+		**/
+		std::string exception;
+		std::jmp_buf exceptionJump;
+
+		char* WritableImage(void);
+
+		// Runs the program with the engine the instance has been configured for.
+		std::uint32_t Enter(void);
+
+		template<bool Threaded, bool Pinned, bool Profile>
+		std::uint32_t Run(u32 start);
+
+		template<bool Profile>
+		std::uint32_t Interpret(u32 start);
+
+		std::uint32_t RunJit(void);
+		std::uint32_t RunNative(void);
+
+		void NativeCall(u32 site);
+
+		// Writes the result of a native call into r2, x2 and f2.
+		void SetResult(const vmb::Bridge::Result&) noexcept;
+
+		// Executes a DIV or MOD whose divisor is 0 or -1, the JIT leaves these to the interpreter.
+		void StepDivision(const Instruction&);
+
+		// Executes an instruction of the x or f registers outside of the interpreter loop, the JIT leaves them to this.
+		void StepWide(const Instruction&);
+
+		/*
+		 * Executes a vector instruction, values holds the r registers of its four operands.
+		 * The result of VDOT and VDOTF is returned, the caller writes it into the register.
+		**/
+		vmb::Bridge::Result StepVector(const Instruction&, const s32* values);
+
+		/*
+		 * Executes MEMCPY, MEMSET or MEMCMP. first, second and count are the values of the address, source and count operands,
+		 * for MEMCMP the ones behind its result register. Returns the result of MEMCMP.
+		**/
+		s32 StepMemory(u8 opcode, u32 first, u32 second, u32 count);
+
+		// Every thread has its own dyncall VM, which is created on the first native call of the thread.
+		static vmb::Bridge& ThreadBridge(void);
+
+		/*
+		 * The callbacks of a compiled program, context is the instance that runs it.
+		**/
+		static void* NativeResolve(void* context, u32 site, u32 library, u32 function);
+		static vmb::Bridge::Result NativeDynamicCall(void* context, u32 site, void* function, const void* const* values);
+		static vmb::Bridge::Result NativeVector(void* context, u32 index, const s32* values);
+		[[noreturn]] static void NativeRaise(void* context, s32 error, s32 reg, s64 value);
+
+		// Describes the error in exception, like "DIVISION BY ZERO ERROR." followed by "[REGISTER 3]: 0" on the next line.
+		void SetException(const char* message, Operand, u32 index, s64 value);
+
+		/*
+		 * Stops the program due to an error inside of it, Execute returns EXECUTION_FAILED.
+		 * It jumps straight back to Enter, nothing on the way gets destroyed, so the detail is formatted here instead of by the caller.
+		**/
+		[[noreturn]] void RaiseException(const char* message, Operand, u32 index, s64 value);
+
+	public:
+		explicit Instance(std::shared_ptr<const Executable>);
+
+		const std::shared_ptr<const Executable>& GetExecutable(void) const noexcept { return executable; }
+
+		void SetDispatch(Dispatch mode) noexcept { dispatch = mode; }
+		Dispatch GetDispatch(void) const noexcept { return dispatch; }
+
+		void SetPinRegisters(bool pin) noexcept { pinRegisters = pin; }
+		bool GetPinRegisters(void) const noexcept { return pinRegisters; }
+
+		void SetProfiling(bool enable);
+		bool GetProfiling(void) const noexcept { return profiler != nullptr; }
+
+		// The statistics of the last profiled run, nullptr if profiling is disabled.
+		const Profiler* GetProfiler(void) const noexcept { return profiler.get(); }
+
+		// The registers can be set before Execute to pass values to the program and read afterwards.
+		std::array<s32, 12>& GetRegisters(void) noexcept { return Registers; }
+		const std::array<s32, 12>& GetRegisters(void) const noexcept { return Registers; }
+		std::array<s64, 12>& GetWideRegisters(void) noexcept { return WideRegisters; }
+		const std::array<s64, 12>& GetWideRegisters(void) const noexcept { return WideRegisters; }
+		std::array<f64, 12>& GetFloatRegisters(void) noexcept { return FloatRegisters; }
+		const std::array<f64, 12>& GetFloatRegisters(void) const noexcept { return FloatRegisters; }
+
+		// The linear memory, it isn't reserved before the first run.
+		const LinearMemory& GetMemory(void) const noexcept { return Memory; }
+
+		// The error that stopped the last run, empty if it ended normally.
+		const std::string& GetException(void) const noexcept { return exception; }
+
+		/*
+		 * Runs the program from its entry point, the registers keep the values they currently have.
+		 * A compiled program runs natively, unless it gets profiled, the profiler needs the interpreter.
+		 * Accesses outside of the linear memory are caught by the fault handler of the platform and raise an exception.
+		 * An exception only stops this instance, Execute returns EXECUTION_FAILED and GetException describes it.
+		**/
+		std::uint32_t Execute(void);
+	};
+
+	/*
+	 * Runs a single binary, this is what the command line uses.
+	 * It owns its executable alone, so it can change the fusion of the program between two runs.
+	**/
+	class InterpreterContext
+	{
+	private:
+		std::shared_ptr<Executable> executable;
+
+		Dispatch dispatch = VMAN_THREADED_DISPATCH ? Dispatch::Threaded : Dispatch::Switch;
+		bool pinRegisters = true;
+
+		// Replaces frequent instruction pairs with superinstructions before the program runs.
+		bool fuse = true;
+
+		/*
+		 * Records the executed opcode pairs and prints them when the program ends,
+		 * the program runs without superinstructions while profiling, so the real pairs show up.
+		**/
+		bool profile = false;
+
 	public:
 		bool OpenFile(const std::string&);
+
+		/*
+		 * Loads a binary that is already in memory, OpenFile maps the file and passes its image to this function.
+		**/
+		bool Load(Image&&);
+		bool Load(std::vector<char>&& bytes) { return Load(Image(std::move(bytes))); }
+
+		const std::shared_ptr<Executable>& GetExecutable(void) const noexcept { return executable; }
+
+		void SetDispatch(Dispatch mode) noexcept { dispatch = mode; }
+		Dispatch GetDispatch(void) const noexcept { return dispatch; }
+
+		void SetPinRegisters(bool pin) noexcept { pinRegisters = pin; }
+		bool GetPinRegisters(void) const noexcept { return pinRegisters; }
+
+		void SetFusion(bool enable) noexcept { fuse = enable; }
+		bool GetFusion(void) const noexcept { return fuse; }
+
+		void SetProfiling(bool enable) noexcept { profile = enable; }
+		bool GetProfiling(void) const noexcept { return profile; }
+
+		/*
+		 * Runs the program with a new instance, every run starts with cleared registers.
+		 * An exception of the program is printed, the result is EXECUTION_FAILED then.
+		**/
 		std::uint32_t Execute(void);
 	};
 };
\ No newline at end of file
@@ -0,0 +1,478 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "jit.hpp"
+
+#include <cstring>
+
+#include "../vmb/dyncall/dyncall_alloc_wx.h"
+
+using vman::core::JitCompiler;
+using vman::core::JitBlock;
+
+using namespace vman;
+using namespace vman::core;
+
+namespace
+{
+	/*
+	 * Blocks without a jump get cut after this many instructions, so straight code doesn't end up in a single huge block.
+	**/
+	constexpr const std::size_t MAX_BLOCK_LENGTH = 64;
+
+	/*
+	 * The emitted code addresses the virtual registers through r8, which is a volatile register on Windows and System V.
+	 * Every virtual register is 4 bytes wide, so the displacement always fits into a single byte.
+	 * The linear memory is addressed through r9, which is volatile on both as well.
+	**/
+	class Emitter
+	{
+	private:
+		std::vector<u8>& out;
+
+		void Bytes(std::initializer_list<u8> values) { out.insert(out.end(), values); }
+
+		void Imm32(u32 value)
+		{
+			for (int i = 0; i < 4; ++i) out.push_back(static_cast<u8>(value >> (i * 8)));
+		}
+
+		// REX.B, opcode, ModRM [r8 + disp8] with the given register field
+		void MemOp(std::initializer_list<u8> opcode, u8 reg, u8 vmRegister)
+		{
+			out.push_back(0x41);
+			out.insert(out.end(), opcode);
+			out.push_back(static_cast<u8>(0x40 | (reg << 3)));
+			out.push_back(static_cast<u8>(vmRegister * sizeof(s32)));
+		}
+
+	public:
+		static constexpr u8 EAX = 0;
+		static constexpr u8 ECX = 1;
+		static constexpr u8 EDX = 2;
+
+		explicit Emitter(std::vector<u8>& buffer) : out(buffer) {}
+
+		std::size_t Size(void) const noexcept { return out.size(); }
+
+		void Prologue(void)
+		{
+#if defined (_WIN32)
+			Bytes({ 0x49, 0x89, 0xC8 }); // mov r8, rcx
+			Bytes({ 0x49, 0x89, 0xD1 }); // mov r9, rdx
+#else
+			Bytes({ 0x49, 0x89, 0xF8 }); // mov r8, rdi
+			Bytes({ 0x49, 0x89, 0xF1 }); // mov r9, rsi
+#endif
+		}
+
+		void Load(u8 reg, u8 vmRegister) { MemOp({ 0x8B }, reg, vmRegister); }
+		void Store(u8 vmRegister, u8 reg) { MemOp({ 0x89 }, reg, vmRegister); }
+
+		// Performs "eax = eax op [r8 + disp8]" for ADD, SUB, MUL, AND, OR, XOR and compares eax for CMP
+		void Arithmetic(u8 opcode, u8 vmRegister)
+		{
+			switch (opcode)
+			{
+				case ADD: MemOp({ 0x03 }, EAX, vmRegister); break;
+				case SUB: MemOp({ 0x2B }, EAX, vmRegister); break;
+				case MUL: MemOp({ 0x0F, 0xAF }, EAX, vmRegister); break;
+				case AND: MemOp({ 0x23 }, EAX, vmRegister); break;
+				case OR: MemOp({ 0x0B }, EAX, vmRegister); break;
+				case XOR: MemOp({ 0x33 }, EAX, vmRegister); break;
+			}
+		}
+
+		void Compare(u8 vmRegister) { MemOp({ 0x3B }, EAX, vmRegister); }
+
+		/*
+		 * Loads eax from [r9 + rax] and stores ecx there. The address has been loaded as a 32 bit value,
+		 * which cleared the upper half of rax, so it can't reach outside of the reserved range.
+		**/
+		void LoadMemory(u8 opcode)
+		{
+			switch (opcode)
+			{
+				case LOAD8: Bytes({ 0x41, 0x0F, 0xB6, 0x04, 0x01 }); break;   // movzx eax, byte [r9 + rax]
+				case LOAD8S: Bytes({ 0x41, 0x0F, 0xBE, 0x04, 0x01 }); break;  // movsx eax, byte [r9 + rax]
+				case LOAD16: Bytes({ 0x41, 0x0F, 0xB7, 0x04, 0x01 }); break;  // movzx eax, word [r9 + rax]
+				case LOAD16S: Bytes({ 0x41, 0x0F, 0xBF, 0x04, 0x01 }); break; // movsx eax, word [r9 + rax]
+				case LOAD32: Bytes({ 0x41, 0x8B, 0x04, 0x01 }); break;        // mov eax, [r9 + rax]
+			}
+		}
+
+		void StoreMemory(u8 opcode)
+		{
+			switch (opcode)
+			{
+				case STORE8: Bytes({ 0x41, 0x88, 0x0C, 0x01 }); break;        // mov [r9 + rax], cl
+				case STORE16: Bytes({ 0x66, 0x41, 0x89, 0x0C, 0x01 }); break; // mov [r9 + rax], cx
+				case STORE32: Bytes({ 0x41, 0x89, 0x0C, 0x01 }); break;       // mov [r9 + rax], ecx
+			}
+		}
+
+		void StoreImmediate(u8 vmRegister, s32 value)
+		{
+			MemOp({ 0xC7 }, 0, vmRegister);
+			Imm32(static_cast<u32>(value));
+		}
+
+		void Not(void) { Bytes({ 0xF7, 0xD0 }); }
+		void ShiftLeft(void) { Bytes({ 0xD3, 0xE0 }); }
+		void ShiftRight(void) { Bytes({ 0xD3, 0xF8 }); }
+		void SignedDivide(void) { Bytes({ 0x99, 0xF7, 0xF9 }); } // cdq, idiv ecx
+		void TestEcx(void) { Bytes({ 0x85, 0xC9 }); }
+		void CompareEcxMinusOne(void) { Bytes({ 0x83, 0xF9, 0xFF }); } // cmp ecx, -1
+
+		// Short conditional jumps, 0x74 = je, 0x75 = jne. Returns the offset of the displacement for Bind.
+		std::size_t Branch(u8 condition)
+		{
+			Bytes({ condition, 0x00 });
+			return out.size() - 1;
+		}
+
+		void Bind(std::size_t displacement)
+		{
+			out[displacement] = static_cast<u8>(out.size() - displacement - 1);
+		}
+
+		// Returns with eax holding the next address, the upper half of rax gets cleared by the 32 bit move.
+		void Return(u32 address)
+		{
+			out.push_back(0xB8);
+			Imm32(address);
+			out.push_back(0xC3);
+		}
+
+		void ReturnRegister(u8 vmRegister)
+		{
+			Load(EAX, vmRegister);
+			out.push_back(0xC3);
+		}
+
+		void Bailout(u32 address)
+		{
+			// mov rax, imm64
+			Bytes({ 0x48, 0xB8 });
+			Imm32(address);
+			Imm32(static_cast<u32>(JIT_BAILOUT >> 32));
+			out.push_back(0xC3);
+		}
+	};
+};
+
+JitCompiler::~JitCompiler(void)
+{
+	Reset();
+}
+
+void JitCompiler::Reset(void)
+{
+	for (const Region& region : regions)
+	{
+		dcFreeWX(region.memory, region.size);
+	}
+	regions.clear();
+	blocks.reset();
+	compiled = false;
+}
+
+bool JitCompiler::Compilable(u8 opcode) noexcept
+{
+	switch (opcode)
+	{
+		case NOP:
+		case MOV:
+		case ADD:
+		case SUB:
+		case DIV:
+		case MUL:
+		case MOD:
+		case LSH:
+		case RSH:
+		case AND:
+		case OR:
+		case XOR:
+		case NOT:
+		case JMP:
+		case JIE:
+		case JNE:
+		case LOAD8:
+		case LOAD8S:
+		case LOAD16:
+		case LOAD16S:
+		case LOAD32:
+		case STORE8:
+		case STORE16:
+		case STORE32:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+void JitCompiler::EmitBlock(const Program& program, u32 index, std::vector<u8>& out)
+{
+	Emitter emit(out);
+	emit.Prologue();
+
+	for (std::size_t length = 0; ; ++index, ++length)
+	{
+		const Instruction& ins = program.code[index];
+
+		// Superinstructions are compiled as the two instructions they consist of.
+		const u8 opcode = Unfused(ins.opcode);
+
+		if (!Compilable(opcode) || length == MAX_BLOCK_LENGTH)
+		{
+			emit.Return(ins.address);
+			return;
+		}
+
+		switch (opcode)
+		{
+			case NOP:
+				break;
+
+			case MOV:
+				emit.StoreImmediate(ins.a, ins.imm);
+				break;
+
+			case ADD:
+			case SUB:
+			case MUL:
+			case AND:
+			case OR:
+			case XOR:
+				emit.Load(Emitter::EAX, ins.b);
+				emit.Arithmetic(opcode, ins.c);
+				emit.Store(ins.a, Emitter::EAX);
+				break;
+
+			case DIV:
+			case MOD:
+			{
+				/*
+				 * A divisor of 0 or -1 leaves the block, the interpreter raises the exception for 0 and
+				 * wraps the minimum divided by -1, on which idiv would trap.
+				**/
+				emit.Load(Emitter::ECX, ins.c);
+				emit.TestEcx();
+				const std::size_t zero = emit.Branch(0x74);
+				emit.CompareEcxMinusOne();
+				const std::size_t divisible = emit.Branch(0x75);
+				emit.Bind(zero);
+				emit.Bailout(ins.address);
+				emit.Bind(divisible);
+				emit.Load(Emitter::EAX, ins.b);
+				emit.SignedDivide();
+				emit.Store(ins.a, opcode == DIV ? Emitter::EAX : Emitter::EDX);
+			} break;
+
+			case LSH:
+			case RSH:
+				emit.Load(Emitter::EAX, ins.b);
+				emit.Load(Emitter::ECX, ins.c);
+				if (opcode == LSH) emit.ShiftLeft();
+				else emit.ShiftRight();
+				emit.Store(ins.a, Emitter::EAX);
+				break;
+
+			case NOT:
+				emit.Load(Emitter::EAX, ins.b);
+				emit.Not();
+				emit.Store(ins.a, Emitter::EAX);
+				break;
+
+			/*
+			 * A fault abandons the block through the fault handler, Instance::Execute raises the exception for it.
+			**/
+			case LOAD8:
+			case LOAD8S:
+			case LOAD16:
+			case LOAD16S:
+			case LOAD32:
+				emit.Load(Emitter::EAX, ins.b);
+				emit.LoadMemory(opcode);
+				emit.Store(ins.a, Emitter::EAX);
+				break;
+
+			case STORE8:
+			case STORE16:
+			case STORE32:
+				emit.Load(Emitter::EAX, ins.a);
+				emit.Load(Emitter::ECX, ins.b);
+				emit.StoreMemory(opcode);
+				break;
+
+			/*
+			 * Jumps the verifier resolved return their target address as a constant.
+			**/
+			case JMP:
+				if (ins.imm != static_cast<s32>(INVALID_INDEX)) emit.Return(program.code[ins.imm].address);
+				else emit.ReturnRegister(ins.a);
+				return;
+
+			case JIE:
+			case JNE:
+			{
+				emit.Load(Emitter::EAX, ins.a);
+				emit.Compare(ins.b);
+				const std::size_t notTaken = emit.Branch(opcode == JIE ? 0x75 : 0x74);
+				if (ins.imm != static_cast<s32>(INVALID_INDEX)) emit.Return(program.code[ins.imm].address);
+				else emit.ReturnRegister(ins.c);
+				emit.Bind(notTaken);
+				emit.Return(program.code[index + 1].address);
+			} return;
+		}
+	}
+}
+
+void* JitCompiler::Commit(const std::vector<u8>& machineCode)
+{
+	void* memory = nullptr;
+	if (dcAllocWX(machineCode.size(), &memory) != 0 || memory == nullptr)
+	{
+		return nullptr;
+	}
+
+	memcpy(memory, machineCode.data(), machineCode.size());
+
+	if (dcInitExecWX(memory, machineCode.size()) != 0)
+	{
+		dcFreeWX(memory, machineCode.size());
+		return nullptr;
+	}
+
+	regions.push_back({ memory, machineCode.size() });
+	return memory;
+}
+
+bool JitCompiler::Compile(const Program& program)
+{
+#if VMAN_JIT
+	std::lock_guard<std::mutex> guard(lock);
+	if (Compiled()) return true;
+
+	blocks = std::make_unique<std::atomic<JitBlock>[]>(program.code.size());
+	for (std::size_t i = 0; i < program.code.size(); ++i)
+	{
+		blocks[i].store(nullptr, std::memory_order_relaxed);
+	}
+
+	std::vector<bool> leaders(program.code.size(), false);
+	leaders[program.entry] = true;
+
+	for (std::size_t i = 0; i < program.code.size(); ++i)
+	{
+		const Instruction& ins = program.code[i];
+		switch (Unfused(ins.opcode))
+		{
+			case JMP:
+			case JIE:
+			case JNE:
+			case NFC:
+			case NFCI:
+				leaders[i + 1] = true;
+				break;
+
+			case MOV:
+			{
+				u32 target = program.IndexOf(static_cast<u32>(ins.imm));
+				if (target != INVALID_INDEX) leaders[target] = true;
+			} break;
+
+			default:
+				// The interpreter executes the instructions of the x and f registers, the vector and the bulk memory instructions
+				// and continues with the next block.
+				if (UsesWideRegisters(ins.opcode) || IsVector(ins.opcode) || IsBulkMemory(ins.opcode)) leaders[i + 1] = true;
+				break;
+		}
+	}
+
+	/*
+	 * All blocks are emitted into one buffer, the machine code doesn't contain absolute addresses,
+	 * so it can be copied into executable memory as a whole afterwards.
+	**/
+	std::vector<u8> machineCode;
+	std::vector<std::size_t> offsets(program.code.size(), 0);
+
+	for (u32 i = 0; i < program.code.size(); ++i)
+	{
+		if (!leaders[i] || !Compilable(Unfused(program.code[i].opcode))) continue;
+
+		offsets[i] = machineCode.size() + 1;
+		EmitBlock(program, i, machineCode);
+	}
+
+	if (!machineCode.empty())
+	{
+		u8* memory = static_cast<u8*>(Commit(machineCode));
+		if (memory == nullptr)
+		{
+			std::cerr << "[ERROR] Failed to allocate executable memory for the JIT.\n";
+			return false;
+		}
+
+		for (std::size_t i = 0; i < offsets.size(); ++i)
+		{
+			if (offsets[i] != 0) blocks[i].store(reinterpret_cast<JitBlock>(memory + offsets[i] - 1), std::memory_order_relaxed);
+		}
+	}
+
+	// Publishes the blocks to every thread that checks Compiled.
+	compiled.store(true, std::memory_order_release);
+	return true;
+#else
+	(void)program;
+	return false;
+#endif
+}
+
+JitBlock JitCompiler::CompileLate(const Program& program, u32 index)
+{
+#if VMAN_JIT
+	if (!Compilable(Unfused(program.code[index].opcode))) return nullptr;
+
+	std::lock_guard<std::mutex> guard(lock);
+
+	// Another thread might have compiled the block in the meantime.
+	JitBlock block = blocks[index].load(std::memory_order_relaxed);
+	if (block != nullptr) return block;
+
+	std::vector<u8> machineCode;
+	EmitBlock(program, index, machineCode);
+
+	void* memory = Commit(machineCode);
+	if (memory == nullptr) return nullptr;
+
+	block = reinterpret_cast<JitBlock>(memory);
+	blocks[index].store(block, std::memory_order_release);
+	return block;
+#else
+	(void)program;
+	(void)index;
+	return nullptr;
+#endif
+}
\ No newline at end of file
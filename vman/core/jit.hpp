@@ -0,0 +1,116 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+#include "types.hpp"
+#include "opcodes.hpp"
+#include "decoder.hpp"
+
+/*
+ * The JIT emits x86-64 machine code, on every other target the interpreter is used instead.
+**/
+#if defined (__x86_64__) || defined (_M_X64)
+#define VMAN_JIT 1
+#else
+#define VMAN_JIT 0
+#endif
+
+namespace vman::core
+{
+	/*
+	 * A compiled basic block, it receives the register array of the virtual machine and the base of its linear memory.
+	 * The lower 32 bits of the result hold the address of the next instruction, if JIT_BAILOUT is set,
+	 * the instruction at this address couldn't be executed natively and has to be run by the interpreter.
+	**/
+	using JitBlock = u64 (*)(s32* registers, char* memory);
+
+	constexpr const u64 JIT_BAILOUT = 1ull << 32;
+
+	/*
+	 * A baseline template JIT, every instruction is translated on its own into a fixed sequence of machine code.
+	 * Blocks run until the next jump or the next instruction the JIT can't handle (NFC, NFCI, HALT, the instructions of the x and f registers and the vector instructions).
+	 * The virtual registers stay in memory, so the interpreter can continue with them at any time.
+	 * Instances of the same executable share one compiler, compiling is serialized, running compiled blocks isn't.
+	**/
+	class JitCompiler
+	{
+	private:
+		struct Region
+		{
+			void* memory;
+			std::size_t size;
+		};
+
+		// Every executable memory region that has been allocated through dyncall.
+		std::vector<Region> regions;
+
+		/*
+		 * The compiled block for every instruction index, nullptr if no block starts there yet.
+		 * Blocks are published atomically, so other threads can run them while further blocks get compiled.
+		**/
+		std::unique_ptr<std::atomic<JitBlock>[]> blocks;
+		std::atomic<bool> compiled = false;
+		std::mutex lock;
+
+		static bool Compilable(u8 opcode) noexcept;
+		static void EmitBlock(const Program&, u32 index, std::vector<u8>& out);
+		void* Commit(const std::vector<u8>& machineCode);
+
+	public:
+		JitCompiler(void) = default;
+		JitCompiler(const JitCompiler&) = delete;
+		JitCompiler& operator=(const JitCompiler&) = delete;
+		~JitCompiler(void);
+
+		// Releases all blocks, this must not happen while any instance is running them.
+		void Reset(void);
+		bool Compiled(void) const noexcept { return compiled.load(std::memory_order_acquire); }
+
+		/*
+		 * Compiles every block whose start address is known ahead of time into one region of executable memory.
+		 * These are the entry point, every instruction that follows a jump or a native call and
+		 * every instruction whose address gets loaded through MOV, since jumps take their target from registers.
+		 * Only the first call compiles, every later one returns right away.
+		**/
+		bool Compile(const Program&);
+
+		/*
+		 * Returns the block that starts at the given instruction, blocks that weren't compiled ahead of time
+		 * are compiled on their first use. Returns nullptr for instructions that have to be interpreted.
+		**/
+		JitBlock Block(const Program& program, u32 index)
+		{
+			JitBlock block = blocks[index].load(std::memory_order_acquire);
+			return block != nullptr ? block : CompileLate(program, index);
+		}
+
+		JitBlock CompileLate(const Program&, u32 index);
+	};
+};
\ No newline at end of file
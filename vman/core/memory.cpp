@@ -0,0 +1,80 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "memory.hpp"
+
+#include <utility>
+
+using vman::core::LinearMemory;
+
+using namespace vman;
+using namespace vman::core;
+
+LinearMemory::LinearMemory(LinearMemory&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+LinearMemory& LinearMemory::operator=(LinearMemory&& other) noexcept
+{
+	if (this != &other)
+	{
+		Release();
+		base = std::exchange(other.base, nullptr);
+		pages = std::exchange(other.pages, 0);
+	}
+	return *this;
+}
+
+LinearMemory::~LinearMemory(void)
+{
+	Release();
+}
+
+bool LinearMemory::Allocate(u32 pageCount)
+{
+	Release();
+
+	// A 32 bit host can't reserve more address space than it has.
+	if (pageCount > MAX_MEMORY_PAGES || RESERVED_SIZE > SIZE_MAX) return false;
+
+	char* memory = static_cast<char*>(vmb::platform::ReserveMemory(static_cast<std::size_t>(RESERVED_SIZE)));
+	if (memory == nullptr) return false;
+
+	if (!vmb::platform::CommitMemory(memory, static_cast<std::size_t>(pageCount) * MEMORY_PAGE_SIZE))
+	{
+		vmb::platform::ReleaseMemory(memory, static_cast<std::size_t>(RESERVED_SIZE));
+		return false;
+	}
+
+	base = memory;
+	pages = pageCount;
+	return true;
+}
+
+void LinearMemory::Release(void) noexcept
+{
+	vmb::platform::ReleaseMemory(base, static_cast<std::size_t>(RESERVED_SIZE));
+	base = nullptr;
+	pages = 0;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "types.hpp"
+#include "image.hpp"
+#include "../vmb/platform.hpp"
+
+namespace vman::core
+{
+	/*
+	 * The linear memory of an instance. The loads and stores address it with the unsigned value of an r register,
+	 * so all 4 GiB a register can reach are reserved up front, followed by a guard for accesses that start right
+	 * below the end. Only the pages the binary asked for are backed by memory, every other access faults and
+	 * the fault gets turned into an exception of the program. This way the interpreter, the JIT and compiled programs
+	 * access memory without comparing a single address.
+	**/
+	class LinearMemory
+	{
+	private:
+		char* base = nullptr;
+		u32 pages = 0;
+
+	public:
+		static constexpr const u64 RESERVED_SIZE = (1ull << 32) + MEMORY_PAGE_SIZE;
+
+		LinearMemory(void) = default;
+		LinearMemory(LinearMemory&&) noexcept;
+		LinearMemory& operator=(LinearMemory&&) noexcept;
+		LinearMemory(const LinearMemory&) = delete;
+		LinearMemory& operator=(const LinearMemory&) = delete;
+		~LinearMemory(void);
+
+		/*
+		 * Reserves the address range and makes the given number of pages accessible, they start zeroed.
+		 * Memory that has been reserved before gets released. Fails on hosts with a 32 bit address space.
+		**/
+		bool Allocate(u32 pageCount);
+		void Release(void) noexcept;
+
+		bool Reserved(void) const noexcept { return base != nullptr; }
+		u32 Pages(void) const noexcept { return pages; }
+		u64 Size(void) const noexcept { return static_cast<u64>(pages) * MEMORY_PAGE_SIZE; }
+
+		char* Data(void) const noexcept { return base; }
+
+		/*
+		 * Runs the function while faults inside the reserved range are caught. Returns false with the faulting address,
+		 * relative to the start of the memory, if the function accessed memory behind the pages.
+		**/
+		template<class F>
+		bool Guard(F&& function, u64& address) const
+		{
+			using Function = std::remove_reference_t<F>;
+
+			std::uintptr_t fault = 0;
+			const bool completed = vmb::platform::GuardedCall([](void* context) { (*static_cast<Function*>(context))(); },
+				&function, base, static_cast<std::size_t>(RESERVED_SIZE), fault);
+
+			if (!completed) address = fault - reinterpret_cast<std::uintptr_t>(base);
+			return completed;
+		}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "types.hpp"
+#include "../vmb/vmb.hpp"
+
+namespace vman::core
+{
+	/*
+	 * A program that has been translated to C through "vman -c" and compiled into a shared library exports its image
+	 * and a function that runs it. The generated source declares the same structure as struct vman_host,
+	 * if either of them changes, NATIVE_ABI has to change as well, modules of another version are refused.
+	**/
+	constexpr const u32 NATIVE_ABI = 4;
+
+	// The errors a compiled program raises through the host, they match the exceptions of the interpreter.
+	enum NativeError : s32
+	{
+		NATIVE_DIVISION_BY_ZERO = 0,
+		NATIVE_INVALID_JUMP = 1,
+		NATIVE_INVALID_PARAMETER = 2,
+		NATIVE_WIDE_DIVISION_BY_ZERO = 3
+	};
+
+	/*
+	 * Everything a compiled program can't do on its own. It resolves the functions of NFC, calls functions whose signature
+	 * has no direct C call, runs the vector and bulk memory instructions and raises exceptions. Imports are resolved while loading
+	 * the module, as for every binary. The vector and bulk memory instructions are identified by their index in the decoded program.
+	 * The loads and stores access the linear memory of the instance directly, the fault handler guards it.
+	**/
+	struct NativeHost
+	{
+		void* context;
+		void* const* imports;
+		char* memory;
+		void* (*resolve)(void* context, u32 site, u32 library, u32 function);
+		vmb::Bridge::Result (*call)(void* context, u32 site, void* function, const void* const* values);
+		vmb::Bridge::Result (*vector)(void* context, u32 index, const s32* values);
+		void (*raise)(void* context, s32 error, s32 reg, s64 value);
+	};
+
+	/*
+	 * Runs the program from its entry point with the given registers of all three banks and writes them back at the end.
+	 * The image is the one the executable loaded, native functions receive pointers into it. Returns 0 after HALT.
+	**/
+	using NativeEntry = s32 (*)(s32* registers, s64* wide, f64* floats, char* image, const NativeHost* host);
+
+	// The names of the symbols every compiled module exports.
+	constexpr const char* NATIVE_ABI_SYMBOL = "vman_abi";
+	constexpr const char* NATIVE_IMAGE_SYMBOL = "vman_image";
+	constexpr const char* NATIVE_IMAGE_SIZE_SYMBOL = "vman_image_size";
+	constexpr const char* NATIVE_ENTRY_SYMBOL = "vman_run";
+};
\ No newline at end of file
@@ -23,6 +23,10 @@
  *
 **/
 
+#include <array>
+#include <cstddef>
+#include <string_view>
+
 #include "types.hpp"
 
 namespace vman::core
@@ -61,4 +65,348 @@ namespace vman::core
 	constexpr const u8 MOV = 0x25;
 	// Call native function during runtime
 	constexpr const u8 NFC = 0x27;
+	// Call a native function of the import table, it has been resolved while loading the binary
+	constexpr const u8 NFCI = 0x28;
+
+	/*
+	 * 64 bit integer arithmetic on the registers x0 to x11, the opcodes follow the order of their 32 bit counterparts.
+	 * Additions, subtractions, multiplications and left shifts wrap around, shift counts are taken modulo 64.
+	**/
+	constexpr const u8 ADDX = 0x30;
+	constexpr const u8 SUBX = 0x31;
+	constexpr const u8 DIVX = 0x32;
+	constexpr const u8 MULX = 0x33;
+	constexpr const u8 MODX = 0x34;
+	constexpr const u8 LSHX = 0x35;
+	constexpr const u8 RSHX = 0x36;
+	constexpr const u8 NOTX = 0x37;
+	constexpr const u8 ANDX = 0x38;
+	constexpr const u8 ORX = 0x39;
+	constexpr const u8 XORX = 0x3A;
+	// Move a 64 bit value into an x register
+	constexpr const u8 MOVX = 0x3D;
+	// Compare two x registers, the r register receives -1, 0 or 1
+	constexpr const u8 CMPX = 0x3E;
+
+	/*
+	 * Double precision arithmetic on the registers f0 to f11.
+	**/
+	constexpr const u8 ADDF = 0x40;
+	constexpr const u8 SUBF = 0x41;
+	constexpr const u8 DIVF = 0x42;
+	constexpr const u8 MULF = 0x43;
+	// Move a double into an f register, the immediate holds its bits
+	constexpr const u8 MOVF = 0x4D;
+	// Compare two f registers, the r register receives -1, 0 or 1, or 2 if either of them is NaN
+	constexpr const u8 CMPF = 0x4E;
+
+	/*
+	 * Conversions between the register banks.
+	**/
+	// Sign extend an r register into an x register
+	constexpr const u8 SEXT = 0x50;
+	// Move the lower 32 bits of an x register into an r register
+	constexpr const u8 TRUNC = 0x51;
+	// Convert an x register into a double
+	constexpr const u8 ITOF = 0x52;
+	// Convert an f register into an x register, rounded towards zero. NaN becomes 0, values out of range saturate.
+	constexpr const u8 FTOI = 0x53;
+
+	/*
+	 * Element wise operations over buffers inside the binary, "vadd d, a, b, n" computes d[i] = a[i] + b[i] for n elements.
+	 * The buffers are addressed through r registers, they have to lie inside the binary and the destination may only
+	 * overlap a source if both start at the same address. The integer opcodes work on 32 bit elements and wrap around.
+	**/
+	constexpr const u8 VADD = 0x60;
+	constexpr const u8 VMUL = 0x61;
+	constexpr const u8 VMIN = 0x62;
+	constexpr const u8 VMAX = 0x63;
+	// The sum of a[i] * b[i] goes into the r register of the first operand, no buffer gets written
+	constexpr const u8 VDOT = 0x64;
+	// d[i] becomes -1 if a[i] < b[i] and 0 otherwise
+	constexpr const u8 VCMP = 0x65;
+	// d[i] = a[i] & b[i], mostly used to apply the masks of VCMP
+	constexpr const u8 VMASK = 0x66;
+
+	/*
+	 * The same operations on doubles, VMINF and VMAXF return the second element if either of them is NaN.
+	 * VDOTF adds the products in eight interleaved sums which are added up in order at the end,
+	 * so its result doesn't depend on the vector instructions of the CPU.
+	**/
+	constexpr const u8 VADDF = 0x68;
+	constexpr const u8 VMULF = 0x69;
+	constexpr const u8 VMINF = 0x6A;
+	constexpr const u8 VMAXF = 0x6B;
+	constexpr const u8 VDOTF = 0x6C;
+
+	/*
+	 * Loads and stores on the linear memory of the instance, addresses are the unsigned value of an r register
+	 * and values are kept in the byte order of the host. "load32 r0, r1" reads r0 from the address in r1,
+	 * "store32 r1, r0" writes r0 to it. The 8 and 16 bit loads zero extend, their S variants sign extend.
+	 * An access that doesn't lie completely inside the memory raises an exception.
+	**/
+	constexpr const u8 LOAD8 = 0x70;
+	constexpr const u8 LOAD8S = 0x71;
+	constexpr const u8 LOAD16 = 0x72;
+	constexpr const u8 LOAD16S = 0x73;
+	constexpr const u8 LOAD32 = 0x74;
+	constexpr const u8 LOADX = 0x75;
+	constexpr const u8 LOADF = 0x76;
+	constexpr const u8 STORE8 = 0x78;
+	constexpr const u8 STORE16 = 0x79;
+	constexpr const u8 STORE32 = 0x7A;
+	constexpr const u8 STOREX = 0x7B;
+	constexpr const u8 STOREF = 0x7C;
+
+	/*
+	 * Bulk operations on the linear memory, the byte counts are unsigned like the addresses.
+	 * "memcpy d, s, n" copies n bytes from s to d, the ranges may overlap. "memset d, v, n" fills n bytes with the lowest byte of v.
+	 * "memcmp r, a, b, n" compares n bytes as unsigned values, r receives -1, 0 or 1 like CMPX.
+	 * Every range has to lie inside the memory, they are checked before anything gets written.
+	**/
+	constexpr const u8 MEMCPY = 0x7D;
+	constexpr const u8 MEMSET = 0x7E;
+	constexpr const u8 MEMCMP = 0x7F;
+
+	/*
+	 * HALT never appears inside a binary file, the decoder appends it behind the last instruction.
+	 * This way the interpreter doesn't have to check if the program counter left the code section.
+	**/
+	constexpr const u8 HALT = 0xFF;
+
+	/*
+	 * Superinstructions, Program::Fuse replaces the opcode of the first of two instructions with one of these.
+	 * The second instruction stays untouched, so jumps that target it still work.
+	**/
+	constexpr const u8 MOV_MOV = 0xF8;
+	constexpr const u8 MOV_ADD = 0xF9;
+	constexpr const u8 SUB_JNE = 0xFA;
+	constexpr const u8 ADD_JNE = 0xFB;
+
+	/*
+	 * How the bytes behind an opcode are laid out, every tool decodes the operands through this.
+	**/
+	enum class Operands : u8
+	{
+		None,              // NOP
+		Register,          // JMP: target register
+		TwoRegisters,      // NOT: destination, source, LOAD8 - LOADF: destination, address, STORE8 - STOREF: address, source
+		ThreeRegisters,    // ADD - XOR: destination, two sources, JIE and JNE: two compared registers, target register
+		RegisterImmediate, // MOV: destination, big endian 32 bit immediate
+		RegisterWide,      // MOVX, MOVF: destination, big endian 64 bit immediate
+		FourRegisters,     // VADD - VDOTF: destination, two sources, element count, MEMCMP: result, two addresses, byte count
+		Types,             // NFC: return type, zero terminated list of parameter types
+		Import,            // NFCI: big endian 16 bit index into the import table
+	};
+
+	struct OpcodeInfo
+	{
+		std::string_view name;
+		Operands operands;
+
+		// Only these opcodes can appear in a binary, every other byte is executed as NOP.
+		bool encodable;
+
+		// The bank of each register operand, 'r', 'x' or 'f'. Empty if all of them are r registers.
+		std::string_view banks = {};
+	};
+
+	/*
+	 * The description of every opcode, indexed by the opcode. Adding an opcode to the instruction set
+	 * only takes an entry here, the decoder, the verifier, the disassembler and the assembler follow it.
+	**/
+	constexpr const std::array<OpcodeInfo, 256> OPCODES = []
+	{
+		std::array<OpcodeInfo, 256> table = {};
+		for (OpcodeInfo& info : table) info = { "???", Operands::None, false };
+
+		table[NOP] = { "nop", Operands::None, true };
+		table[ADD] = { "add", Operands::ThreeRegisters, true };
+		table[SUB] = { "sub", Operands::ThreeRegisters, true };
+		table[DIV] = { "div", Operands::ThreeRegisters, true };
+		table[MUL] = { "mul", Operands::ThreeRegisters, true };
+		table[MOD] = { "mod", Operands::ThreeRegisters, true };
+		table[LSH] = { "lsh", Operands::ThreeRegisters, true };
+		table[RSH] = { "rsh", Operands::ThreeRegisters, true };
+		table[NOT] = { "not", Operands::TwoRegisters, true };
+		table[AND] = { "and", Operands::ThreeRegisters, true };
+		table[OR] = { "or", Operands::ThreeRegisters, true };
+		table[XOR] = { "xor", Operands::ThreeRegisters, true };
+		table[JMP] = { "jmp", Operands::Register, true };
+		table[JIE] = { "jie", Operands::ThreeRegisters, true };
+		table[JNE] = { "jne", Operands::ThreeRegisters, true };
+		table[MOV] = { "mov", Operands::RegisterImmediate, true };
+		table[NFC] = { "nfc", Operands::Types, true };
+		table[NFCI] = { "nfci", Operands::Import, true };
+
+		table[ADDX] = { "addx", Operands::ThreeRegisters, true, "xxx" };
+		table[SUBX] = { "subx", Operands::ThreeRegisters, true, "xxx" };
+		table[DIVX] = { "divx", Operands::ThreeRegisters, true, "xxx" };
+		table[MULX] = { "mulx", Operands::ThreeRegisters, true, "xxx" };
+		table[MODX] = { "modx", Operands::ThreeRegisters, true, "xxx" };
+		table[LSHX] = { "lshx", Operands::ThreeRegisters, true, "xxx" };
+		table[RSHX] = { "rshx", Operands::ThreeRegisters, true, "xxx" };
+		table[NOTX] = { "notx", Operands::TwoRegisters, true, "xx" };
+		table[ANDX] = { "andx", Operands::ThreeRegisters, true, "xxx" };
+		table[ORX] = { "orx", Operands::ThreeRegisters, true, "xxx" };
+		table[XORX] = { "xorx", Operands::ThreeRegisters, true, "xxx" };
+		table[MOVX] = { "movx", Operands::RegisterWide, true, "x" };
+		table[CMPX] = { "cmpx", Operands::ThreeRegisters, true, "rxx" };
+
+		table[ADDF] = { "addf", Operands::ThreeRegisters, true, "fff" };
+		table[SUBF] = { "subf", Operands::ThreeRegisters, true, "fff" };
+		table[DIVF] = { "divf", Operands::ThreeRegisters, true, "fff" };
+		table[MULF] = { "mulf", Operands::ThreeRegisters, true, "fff" };
+		table[MOVF] = { "movf", Operands::RegisterWide, true, "f" };
+		table[CMPF] = { "cmpf", Operands::ThreeRegisters, true, "rff" };
+
+		table[SEXT] = { "sext", Operands::TwoRegisters, true, "xr" };
+		table[TRUNC] = { "trunc", Operands::TwoRegisters, true, "rx" };
+		table[ITOF] = { "itof", Operands::TwoRegisters, true, "fx" };
+		table[FTOI] = { "ftoi", Operands::TwoRegisters, true, "xf" };
+
+		table[VADD] = { "vadd", Operands::FourRegisters, true };
+		table[VMUL] = { "vmul", Operands::FourRegisters, true };
+		table[VMIN] = { "vmin", Operands::FourRegisters, true };
+		table[VMAX] = { "vmax", Operands::FourRegisters, true };
+		table[VDOT] = { "vdot", Operands::FourRegisters, true };
+		table[VCMP] = { "vcmp", Operands::FourRegisters, true };
+		table[VMASK] = { "vmask", Operands::FourRegisters, true };
+		table[VADDF] = { "vaddf", Operands::FourRegisters, true };
+		table[VMULF] = { "vmulf", Operands::FourRegisters, true };
+		table[VMINF] = { "vminf", Operands::FourRegisters, true };
+		table[VMAXF] = { "vmaxf", Operands::FourRegisters, true };
+		table[VDOTF] = { "vdotf", Operands::FourRegisters, true, "frrr" };
+
+		table[LOAD8] = { "load8", Operands::TwoRegisters, true };
+		table[LOAD8S] = { "load8s", Operands::TwoRegisters, true };
+		table[LOAD16] = { "load16", Operands::TwoRegisters, true };
+		table[LOAD16S] = { "load16s", Operands::TwoRegisters, true };
+		table[LOAD32] = { "load32", Operands::TwoRegisters, true };
+		table[LOADX] = { "loadx", Operands::TwoRegisters, true, "xr" };
+		table[LOADF] = { "loadf", Operands::TwoRegisters, true, "fr" };
+		table[STORE8] = { "store8", Operands::TwoRegisters, true };
+		table[STORE16] = { "store16", Operands::TwoRegisters, true };
+		table[STORE32] = { "store32", Operands::TwoRegisters, true };
+		table[STOREX] = { "storex", Operands::TwoRegisters, true, "rx" };
+		table[STOREF] = { "storef", Operands::TwoRegisters, true, "rf" };
+
+		table[MEMCPY] = { "memcpy", Operands::ThreeRegisters, true };
+		table[MEMSET] = { "memset", Operands::ThreeRegisters, true };
+		table[MEMCMP] = { "memcmp", Operands::FourRegisters, true };
+
+		// Internal opcodes, they only exist in decoded programs.
+		table[HALT] = { "halt", Operands::None, false };
+		table[MOV_MOV] = { "mov+mov", Operands::RegisterImmediate, false };
+		table[MOV_ADD] = { "mov+add", Operands::RegisterImmediate, false };
+		table[SUB_JNE] = { "sub+jne", Operands::ThreeRegisters, false };
+		table[ADD_JNE] = { "add+jne", Operands::ThreeRegisters, false };
+		return table;
+	}();
+
+	// Number of register operands, they always come first.
+	constexpr std::size_t RegisterOperands(Operands operands) noexcept
+	{
+		switch (operands)
+		{
+			case Operands::Register: return 1;
+			case Operands::TwoRegisters: return 2;
+			case Operands::ThreeRegisters: return 3;
+			case Operands::RegisterImmediate: return 1;
+			case Operands::RegisterWide: return 1;
+			case Operands::FourRegisters: return 4;
+			default: return 0;
+		}
+	}
+
+	// The bank of a register operand, 'r', 'x' or 'f'.
+	constexpr char RegisterBank(const OpcodeInfo& info, std::size_t operand) noexcept
+	{
+		return operand < info.banks.size() ? info.banks[operand] : 'r';
+	}
+
+	/*
+	 * Returns true if the opcode works on the x or f registers, the JIT leaves these opcodes to the interpreter.
+	**/
+	constexpr bool UsesWideRegisters(u8 opcode) noexcept
+	{
+		return !OPCODES[opcode].banks.empty();
+	}
+
+	// Returns true for the opcodes that work on buffers, the JIT leaves them to the interpreter as well.
+	constexpr bool IsVector(u8 opcode) noexcept
+	{
+		return opcode >= VADD && opcode <= VDOTF;
+	}
+
+	// Returns true for MEMCPY, MEMSET and MEMCMP, which the JIT leaves to the interpreter too.
+	constexpr bool IsBulkMemory(u8 opcode) noexcept
+	{
+		return opcode >= MEMCPY && opcode <= MEMCMP;
+	}
+
+	// Returns true for the loads, stores and bulk operations, a program that contains any of them gets linear memory.
+	constexpr bool AccessesMemory(u8 opcode) noexcept
+	{
+		return opcode >= LOAD8 && opcode <= MEMCMP;
+	}
+
+	/*
+	 * Returns the opcode a byte of a binary is executed as, that is the byte itself or NOP.
+	**/
+	constexpr u8 Decoded(u8 byte) noexcept
+	{
+		return OPCODES[byte].encodable ? byte : NOP;
+	}
+
+	/*
+	 * Length of the instruction that starts at bytes[0], available is the number of bytes up to the end of the binary.
+	 * The result is larger than available if the instruction is truncated.
+	 * In version 1 binaries, padded, the type list of NFC is followed by one more byte, the first versions of virtual man
+	 * skipped it. Later versions end NFC with the terminator of its type list.
+	**/
+	constexpr std::size_t InstructionLength(const u8* bytes, std::size_t available, bool padded = false) noexcept
+	{
+		switch (OPCODES[Decoded(bytes[0])].operands)
+		{
+			case Operands::None: return 1;
+			case Operands::Register: return 2;
+			case Operands::TwoRegisters: return 3;
+			case Operands::ThreeRegisters: return 4;
+			case Operands::RegisterImmediate: return 6;
+			case Operands::RegisterWide: return 10;
+			case Operands::FourRegisters: return 5;
+			case Operands::Import: return 3;
+
+			case Operands::Types:
+			{
+				std::size_t i = 2;
+				while (i < available && bytes[i]) ++i;
+
+				// The padding of the last instruction may be missing, the end of the code section is reached either way.
+				return padded && i + 1 < available ? i + 2 : i + 1;
+			}
+		}
+		return 1;
+	}
+
+	// The immediate of MOV is big endian encoded
+	constexpr s32 Immediate(const u8* bytes) noexcept
+	{
+		return static_cast<s32>((static_cast<u32>(bytes[2]) << 24) | (static_cast<u32>(bytes[3]) << 16) | (static_cast<u32>(bytes[4]) << 8) | static_cast<u32>(bytes[5]));
+	}
+
+	// And so is the one of MOVX and MOVF
+	constexpr u64 WideImmediate(const u8* bytes) noexcept
+	{
+		u64 value = 0;
+		for (std::size_t i = 0; i < 8; ++i) value = (value << 8) | bytes[2 + i];
+		return value;
+	}
+
+	// So is the import index of NFCI
+	constexpr u16 ImportIndex(const u8* bytes) noexcept
+	{
+		return static_cast<u16>((bytes[1] << 8) | bytes[2]);
+	}
 };
\ No newline at end of file
@@ -0,0 +1,157 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "pool.hpp"
+
+#include <algorithm>
+
+using vman::core::ThreadPool;
+
+namespace
+{
+	// The pool and the index of the worker that runs on the current thread.
+	thread_local const ThreadPool* currentPool = nullptr;
+	thread_local std::size_t currentWorker = 0;
+};
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+	if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+	queues.reserve(threads);
+	for (std::size_t i = 0; i < threads; ++i)
+	{
+		queues.push_back(std::make_unique<Queue>());
+	}
+
+	workers.reserve(threads);
+	for (std::size_t i = 0; i < threads; ++i)
+	{
+		workers.emplace_back(&ThreadPool::Work, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool(void)
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	available.notify_all();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+std::size_t ThreadPool::CurrentWorker(void) const noexcept
+{
+	return currentPool == this ? currentWorker : Size();
+}
+
+void ThreadPool::Push(std::function<void()>&& job)
+{
+	std::size_t worker = CurrentWorker();
+	if (worker == Size()) worker = next.fetch_add(1, std::memory_order_relaxed) % Size();
+
+	/*
+	 * queued changes under the lock of the queue together with its jobs, so a worker that sees a job waiting
+	 * finds it in one of the queues, unless another worker takes it first.
+	**/
+	pending.fetch_add(1);
+	{
+		std::lock_guard<std::mutex> guard(queues[worker]->lock);
+		queues[worker]->jobs.push_back(std::move(job));
+		queued.fetch_add(1);
+	}
+
+	// Taking the lock makes sure that a worker which is about to sleep sees the new job.
+	{
+		std::lock_guard<std::mutex> guard(lock);
+	}
+	available.notify_one();
+}
+
+bool ThreadPool::Pop(std::size_t worker, std::function<void()>& job)
+{
+	{
+		Queue& own = *queues[worker];
+		std::lock_guard<std::mutex> guard(own.lock);
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			queued.fetch_sub(1);
+			return true;
+		}
+	}
+
+	for (std::size_t i = 1; i < queues.size(); ++i)
+	{
+		Queue& victim = *queues[(worker + i) % queues.size()];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			queued.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::Work(std::size_t worker)
+{
+	currentPool = this;
+	currentWorker = worker;
+
+	for (;;)
+	{
+		std::function<void()> job;
+		if (!Pop(worker, job))
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			available.wait(guard, [this] { return stopping || queued.load() != 0; });
+
+			// Queued jobs still run when the pool gets destroyed.
+			if (stopping && queued.load() == 0) return;
+			continue;
+		}
+
+		job();
+
+		if (pending.fetch_sub(1) == 1)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			finished.notify_all();
+		}
+	}
+}
+
+void ThreadPool::Wait(void)
+{
+	std::unique_lock<std::mutex> guard(lock);
+	finished.wait(guard, [this] { return pending.load() == 0; });
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+#include "types.hpp"
+#include "interpreter.hpp"
+
+namespace vman::core
+{
+	/*
+	 * A fixed set of worker threads with a queue for each of them.
+	 * Jobs that are submitted from outside get spread over the queues, jobs that a worker submits land in its own queue.
+	 * A worker takes the newest job of its own queue first and steals the oldest job of another queue once its own is empty,
+	 * so a few long running jobs never leave the other workers idle.
+	 * Together with a shared executable it runs one instance per request on every core:
+	 *
+	 * auto executable = Executable::Open("program.bin");
+	 * std::vector<Instance> instances;
+	 * for (std::size_t i = 0; i < requests; ++i) instances.emplace_back(executable);
+	 *
+	 * ThreadPool pool;
+	 * for (Instance& instance : instances) pool.Execute(instance);
+	 * pool.Wait();
+	**/
+	class ThreadPool
+	{
+	private:
+		struct Queue
+		{
+			std::mutex lock;
+			std::deque<std::function<void()>> jobs;
+		};
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> workers;
+
+		// The queue that receives the next job submitted from outside of the pool.
+		std::atomic<std::size_t> next = 0;
+
+		// Jobs that are waiting in any of the queues.
+		std::atomic<std::size_t> queued = 0;
+
+		// Jobs that have been submitted but haven't finished yet.
+		std::atomic<std::size_t> pending = 0;
+
+		bool stopping = false;
+
+		// Only used to put idle workers and Wait to sleep, the queues have their own locks.
+		std::mutex lock;
+		std::condition_variable available;
+		std::condition_variable finished;
+
+		void Push(std::function<void()>&& job);
+		bool Pop(std::size_t worker, std::function<void()>& job);
+		void Work(std::size_t worker);
+
+	public:
+		// Starts the given number of workers, 0 starts one worker per hardware thread.
+		explicit ThreadPool(std::size_t threads = 0);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// Finishes every job that has been submitted and stops the workers.
+		~ThreadPool(void);
+
+		std::size_t Size(void) const noexcept { return workers.size(); }
+
+		/*
+		 * Returns the index of the worker that calls this function, Size() if it isn't called by a worker of this pool.
+		 * Jobs use it to pick state that belongs to their worker.
+		**/
+		std::size_t CurrentWorker(void) const noexcept;
+
+		/*
+		 * Queues a job, the returned future holds its result once one of the workers has run it.
+		**/
+		template<class F>
+		std::future<std::invoke_result_t<F>> Submit(F&& job)
+		{
+			using Result = std::invoke_result_t<F>;
+
+			auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+			std::future<Result> result = task->get_future();
+			Push([task] { (*task)(); });
+			return result;
+		}
+
+		/*
+		 * Runs an instance on one of the workers, the instance has to stay alive until it has finished.
+		**/
+		std::future<std::uint32_t> Execute(Instance& instance)
+		{
+			return Submit([&instance] { return instance.Execute(); });
+		}
+
+		// Blocks until every job that has been submitted so far has finished.
+		void Wait(void);
+	};
+};
\ No newline at end of file
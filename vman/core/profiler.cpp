@@ -0,0 +1,177 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+using vman::core::Profiler;
+
+using namespace vman;
+using namespace vman::core;
+
+void Profiler::Reset(std::size_t instructions)
+{
+	pairs.assign(256 * 256, 0);
+	cycles.assign(256, 0);
+	hits.assign(instructions, 0);
+	calls.clear();
+	previous = HALT;
+	last = Now();
+}
+
+namespace
+{
+	// Reads a name of an NFC target from the image, without reading past its end.
+	std::string Name(const Image& image, u32 offset)
+	{
+		if (offset >= image.size()) return "???";
+
+		const char* name = &image[offset];
+		const char* end = static_cast<const char*>(memchr(name, '\0', image.size() - offset));
+		return std::string(name, end != nullptr ? end : image.data() + image.size());
+	}
+
+	std::ostream& Percent(std::ostream& out, u64 part, u64 total)
+	{
+		return out << std::fixed << std::setprecision(2) << (total != 0 ? 100.0 * part / total : 0.0) << "%" << std::defaultfloat;
+	}
+};
+
+void Profiler::Report(std::ostream& out, const Program& program, const Image& image) const
+{
+	/*
+	 * HALT is only the predecessor of the very first instruction,
+	 * its cycles are the time between Reset and the first dispatch.
+	**/
+	u64 totalCycles = 0;
+	std::vector<u8> opcodes;
+	for (std::size_t opcode = 0; opcode < 256; ++opcode)
+	{
+		if (opcode == HALT || Count(static_cast<u8>(opcode)) == 0) continue;
+
+		opcodes.push_back(static_cast<u8>(opcode));
+		totalCycles += cycles[opcode];
+	}
+	std::sort(opcodes.begin(), opcodes.end(), [this](u8 a, u8 b) { return cycles[a] > cycles[b]; });
+
+	out << "\n[PROFILE] Executed opcodes, " << totalCycles << " cycles in total:\n";
+	for (u8 opcode : opcodes)
+	{
+		const u64 count = Count(opcode);
+		out << "[PROFILE] " << std::setw(7) << OPCODES[opcode].name << ": " << count << " times, " << cycles[opcode] << " cycles (";
+		Percent(out, cycles[opcode], totalCycles) << "), " << std::fixed << std::setprecision(1)
+			<< static_cast<double>(cycles[opcode]) / count << " cycles each\n" << std::defaultfloat;
+	}
+
+	/*
+	 * The HALT the decoder appends behind the last instruction isn't part of the binary, it's left out.
+	**/
+	std::vector<u32> hot;
+	u64 totalHits = 0;
+	std::size_t instructions = 0;
+	for (u32 i = 0; i < hits.size(); ++i)
+	{
+		if (program.code[i].opcode == HALT) continue;
+
+		++instructions;
+		if (hits[i] == 0) continue;
+
+		hot.push_back(i);
+		totalHits += hits[i];
+	}
+	std::sort(hot.begin(), hot.end(), [this](u32 a, u32 b) { return hits[a] > hits[b]; });
+
+	out << "\n[PROFILE] Hot spots, " << hot.size() << " of " << instructions << " instructions executed:\n";
+	for (std::size_t i = 0; i < hot.size() && i < 20; ++i)
+	{
+		const Instruction& ins = program.code[hot[i]];
+		out << "[PROFILE] 0x" << std::hex << std::setw(8) << std::setfill('0') << ins.address << std::dec << std::setfill(' ')
+			<< " " << std::setw(7) << OPCODES[ins.opcode].name << ": " << hits[hot[i]] << " (";
+		Percent(out, hits[hot[i]], totalHits) << ")\n";
+	}
+
+	if (!calls.empty())
+	{
+		std::vector<std::pair<std::pair<u32, u32>, Calls>> targets(calls.begin(), calls.end());
+		std::sort(targets.begin(), targets.end(), [](const auto& a, const auto& b) { return a.second.cycles > b.second.cycles; });
+
+		out << "\n[PROFILE] Native calls:\n";
+		for (const auto& [names, target] : targets)
+		{
+			out << "[PROFILE] " << Name(image, names.first) << "!" << Name(image, names.second) << ": " << target.count << " calls, "
+				<< target.cycles << " cycles, " << std::fixed << std::setprecision(1) << static_cast<double>(target.cycles) / target.count
+				<< " cycles each\n" << std::defaultfloat;
+		}
+	}
+
+	struct Pair
+	{
+		u8 first;
+		u8 second;
+		u64 count;
+	};
+
+	std::vector<Pair> executed;
+	u64 total = 0;
+
+	for (std::size_t i = 0; i < pairs.size(); ++i)
+	{
+		if (pairs[i] == 0 || i / 256 == HALT) continue;
+
+		executed.push_back({ static_cast<u8>(i / 256), static_cast<u8>(i % 256), pairs[i] });
+		total += pairs[i];
+	}
+
+	std::sort(executed.begin(), executed.end(), [](const Pair& a, const Pair& b) { return a.count > b.count; });
+
+	out << "\n[PROFILE] Executed opcode pairs, " << total << " dispatches in total:\n";
+	for (std::size_t i = 0; i < executed.size() && i < 20; ++i)
+	{
+		const Pair& pair = executed[i];
+		out << "[PROFILE] " << std::setw(4) << OPCODES[pair.first].name << " -> " << std::setw(4) << OPCODES[pair.second].name << ": " << pair.count << " (";
+		Percent(out, pair.count, total) << ")" << (Superinstruction(pair.first, pair.second) != NOP ? " [fused]" : "") << "\n";
+	}
+}
+
+u64 Profiler::Dispatches(void) const noexcept
+{
+	u64 total = 0;
+	for (u64 count : pairs)
+	{
+		total += count;
+	}
+	return total;
+}
+
+u64 Profiler::Count(u8 opcode) const noexcept
+{
+	u64 total = 0;
+	for (std::size_t first = 0; first < 256; ++first)
+	{
+		total += pairs[first * 256 + opcode];
+	}
+	return total;
+}
\ No newline at end of file
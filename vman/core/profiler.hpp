@@ -0,0 +1,120 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <map>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <ostream>
+
+#if defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86))
+#include <intrin.h>
+#elif defined (__x86_64__) || defined (__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "types.hpp"
+#include "opcodes.hpp"
+#include "decoder.hpp"
+
+namespace vman::core
+{
+	/*
+	 * Collects statistics while the interpreter runs, this is only compiled into the interpreter loop
+	 * if profiling has been enabled, so it costs nothing otherwise.
+	 * Every dispatch is charged with the time until the next one, the time of an NFC includes its native call.
+	**/
+	class Profiler
+	{
+	private:
+		// How often each opcode has been followed by another one, indexed by first * 256 + second.
+		std::vector<u64> pairs;
+
+		// The cycles spent in every opcode.
+		std::vector<u64> cycles;
+
+		// How often every instruction has been dispatched, indexed like Program::code.
+		std::vector<u64> hits;
+
+		struct Calls
+		{
+			u64 count = 0;
+			u64 cycles = 0;
+		};
+
+		// The native calls grouped by the addresses of their library and function names.
+		std::map<std::pair<u32, u32>, Calls> calls;
+
+		u8 previous = HALT;
+		u64 last = 0;
+
+	public:
+		/*
+		 * Reads the time stamp counter where the CPU has one, elsewhere nanoseconds are counted instead of cycles.
+		**/
+		static u64 Now(void) noexcept
+		{
+#if defined (_M_X64) || defined (_M_IX86) || defined (__x86_64__) || defined (__i386__)
+			return __rdtsc();
+#else
+			return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+		}
+
+		// Clears all statistics for a program with the given number of instructions.
+		void Reset(std::size_t instructions);
+
+		void Record(u8 opcode, u32 index) noexcept
+		{
+			const u64 now = Now();
+			cycles[previous] += now - last;
+			last = now;
+
+			pairs[previous * 256 + opcode]++;
+			hits[index]++;
+			previous = opcode;
+		}
+
+		void RecordCall(u32 library, u32 function, u64 elapsed)
+		{
+			Calls& target = calls[{ library, function }];
+			target.count++;
+			target.cycles += elapsed;
+		}
+
+		/*
+		 * Prints the executed opcodes sorted by the cycles spent in them, the most executed instructions,
+		 * the native call targets sorted by their total latency and the executed opcode pairs sorted by frequency.
+		 * Pairs that are already fused into a superinstruction are marked, the others are candidates for new superinstructions.
+		**/
+		void Report(std::ostream&, const Program&, const Image&) const;
+
+		// Number of dispatches that have been recorded since the last Reset.
+		u64 Dispatches(void) const noexcept;
+
+		// Number of times the given opcode has been dispatched since the last Reset.
+		u64 Count(u8 opcode) const noexcept;
+	};
+};
\ No newline at end of file
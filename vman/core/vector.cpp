@@ -0,0 +1,484 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "vector.hpp"
+
+#include <atomic>
+#include <cstring>
+
+#if VMAN_VECTOR_X86
+#include <immintrin.h>
+#if defined (_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+using namespace vman;
+using namespace vman::core;
+
+/*
+ * GCC and Clang only emit the instructions of the enabled instruction sets, every kernel enables its own.
+ * MSVC emits any intrinsic without special flags. This file is compiled with -ffp-contract=off,
+ * otherwise the AVX-512 kernels would fuse multiplications and additions, which rounds differently than the other levels.
+**/
+#if defined (__GNUC__)
+#define VMAN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define VMAN_TARGET(isa)
+#endif
+
+namespace
+{
+	// The elements of VDOTF are added into this many interleaved sums, see VDOTF.
+	constexpr const std::size_t DOT_LANES = 8;
+
+	// Buffers inside the image don't have to be aligned, so every element gets copied.
+	template<class T>
+	T Load(const char* buffer, std::size_t index) noexcept
+	{
+		T value;
+		memcpy(&value, buffer + index * sizeof(T), sizeof(T));
+		return value;
+	}
+
+	template<class T>
+	void Store(char* buffer, std::size_t index, T value) noexcept
+	{
+		memcpy(buffer + index * sizeof(T), &value, sizeof(T));
+	}
+
+	/*
+	 * What every opcode does with a single pair of elements. The scalar kernels are built from these,
+	 * the other kernels use them for the elements behind their last full vector.
+	**/
+	struct Add
+	{
+		static s32 Apply(s32 a, s32 b) noexcept { return static_cast<s32>(static_cast<u32>(a) + static_cast<u32>(b)); }
+		static f64 Apply(f64 a, f64 b) noexcept { return a + b; }
+	};
+
+	struct Mul
+	{
+		static s32 Apply(s32 a, s32 b) noexcept { return static_cast<s32>(static_cast<u32>(a) * static_cast<u32>(b)); }
+		static f64 Apply(f64 a, f64 b) noexcept { return a * b; }
+	};
+
+	// Written like minpd and maxpd, so NaN and signed zeros give the same result on every level.
+	struct Min
+	{
+		template<class T>
+		static T Apply(T a, T b) noexcept { return a < b ? a : b; }
+	};
+
+	struct Max
+	{
+		template<class T>
+		static T Apply(T a, T b) noexcept { return a > b ? a : b; }
+	};
+
+	struct Compare
+	{
+		static s32 Apply(s32 a, s32 b) noexcept { return a < b ? -1 : 0; }
+	};
+
+	struct Mask
+	{
+		static s32 Apply(s32 a, s32 b) noexcept { return a & b; }
+	};
+
+	template<class Op, class T>
+	void Elements(char* destination, const char* a, const char* b, std::size_t from, std::size_t count) noexcept
+	{
+		for (std::size_t i = from; i < count; ++i)
+		{
+			Store(destination, i, Op::Apply(Load<T>(a, i), Load<T>(b, i)));
+		}
+	}
+
+	template<class Op, class T>
+	void ScalarKernel(char* destination, const char* a, const char* b, std::size_t count) noexcept
+	{
+		Elements<Op, T>(destination, a, b, 0, count);
+	}
+
+	// The products are added with wrap around, so the order doesn't matter and every level can use its own.
+	s32 DotElements(const char* a, const char* b, std::size_t from, std::size_t count, u32 sum) noexcept
+	{
+		for (std::size_t i = from; i < count; ++i)
+		{
+			sum += static_cast<u32>(Load<s32>(a, i)) * static_cast<u32>(Load<s32>(b, i));
+		}
+		return static_cast<s32>(sum);
+	}
+
+	u32 SumLanes(const s32* lanes, std::size_t count) noexcept
+	{
+		u32 sum = 0;
+		for (std::size_t i = 0; i < count; ++i) sum += static_cast<u32>(lanes[i]);
+		return sum;
+	}
+
+	s32 ScalarDot(const char* a, const char* b, std::size_t count) noexcept
+	{
+		return DotElements(a, b, 0, count, 0);
+	}
+
+	/*
+	 * Adds up the interleaved sums in order, followed by the products of the elements behind the last full group.
+	**/
+	f64 FinishDot(const f64 (&lanes)[DOT_LANES], const char* a, const char* b, std::size_t from, std::size_t count) noexcept
+	{
+		f64 sum = 0.0;
+		for (f64 lane : lanes) sum += lane;
+		for (std::size_t i = from; i < count; ++i) sum += Load<f64>(a, i) * Load<f64>(b, i);
+		return sum;
+	}
+
+	f64 ScalarDotF(const char* a, const char* b, std::size_t count) noexcept
+	{
+		f64 lanes[DOT_LANES] = {};
+		const std::size_t full = count - count % DOT_LANES;
+		for (std::size_t i = 0; i < full; i += DOT_LANES)
+		{
+			for (std::size_t lane = 0; lane < DOT_LANES; ++lane)
+			{
+				lanes[lane] += Load<f64>(a, i + lane) * Load<f64>(b, i + lane);
+			}
+		}
+		return FinishDot(lanes, a, b, full, count);
+	}
+
+	constexpr const VectorKernels SCALAR =
+	{
+		VectorLevel::Scalar,
+		&ScalarKernel<Add, s32>, &ScalarKernel<Mul, s32>, &ScalarKernel<Min, s32>, &ScalarKernel<Max, s32>,
+		&ScalarKernel<Compare, s32>, &ScalarKernel<Mask, s32>, &ScalarDot,
+		&ScalarKernel<Add, f64>, &ScalarKernel<Mul, f64>, &ScalarKernel<Min, f64>, &ScalarKernel<Max, f64>, &ScalarDotF
+	};
+
+#if VMAN_VECTOR_X86
+	/*
+	 * A kernel that runs the intrinsic op over every full vector of width elements, the rest goes through the scalar operation.
+	**/
+#define VMAN_KERNEL(name, isa, T, width, load, store, op, Op) \
+	VMAN_TARGET(isa) void name(char* destination, const char* a, const char* b, std::size_t count) noexcept \
+	{ \
+		std::size_t i = 0; \
+		for (; i + (width) <= count; i += (width)) \
+		{ \
+			store(destination + i * sizeof(T), op(load(a + i * sizeof(T)), load(b + i * sizeof(T)))); \
+		} \
+		Elements<Op, T>(destination, a, b, i, count); \
+	}
+
+	/*
+	 * SSE2, every x86-64 CPU has it. It has no 32 bit multiplication, minimum and maximum,
+	 * these are built from the 64 bit multiplication and the compares.
+	**/
+	VMAN_TARGET("sse2") inline __m128i LoadSSE2(const char* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+	VMAN_TARGET("sse2") inline void StoreSSE2(char* p, __m128i v) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+	VMAN_TARGET("sse2") inline __m128d LoadFSSE2(const char* p) noexcept { return _mm_loadu_pd(reinterpret_cast<const double*>(p)); }
+	VMAN_TARGET("sse2") inline void StoreFSSE2(char* p, __m128d v) noexcept { _mm_storeu_pd(reinterpret_cast<double*>(p), v); }
+
+	VMAN_TARGET("sse2") inline __m128i MulSSE2(__m128i a, __m128i b) noexcept
+	{
+		const __m128i even = _mm_mul_epu32(a, b);
+		const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	VMAN_TARGET("sse2") inline __m128i MinSSE2(__m128i a, __m128i b) noexcept
+	{
+		const __m128i less = _mm_cmplt_epi32(a, b);
+		return _mm_or_si128(_mm_and_si128(less, a), _mm_andnot_si128(less, b));
+	}
+
+	VMAN_TARGET("sse2") inline __m128i MaxSSE2(__m128i a, __m128i b) noexcept
+	{
+		const __m128i greater = _mm_cmpgt_epi32(a, b);
+		return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+	}
+
+	VMAN_KERNEL(AddSSE2, "sse2", s32, 4, LoadSSE2, StoreSSE2, _mm_add_epi32, Add)
+	VMAN_KERNEL(MulKernelSSE2, "sse2", s32, 4, LoadSSE2, StoreSSE2, MulSSE2, Mul)
+	VMAN_KERNEL(MinKernelSSE2, "sse2", s32, 4, LoadSSE2, StoreSSE2, MinSSE2, Min)
+	VMAN_KERNEL(MaxKernelSSE2, "sse2", s32, 4, LoadSSE2, StoreSSE2, MaxSSE2, Max)
+	VMAN_KERNEL(CompareSSE2, "sse2", s32, 4, LoadSSE2, StoreSSE2, _mm_cmplt_epi32, Compare)
+	VMAN_KERNEL(MaskSSE2, "sse2", s32, 4, LoadSSE2, StoreSSE2, _mm_and_si128, Mask)
+	VMAN_KERNEL(AddFSSE2, "sse2", f64, 2, LoadFSSE2, StoreFSSE2, _mm_add_pd, Add)
+	VMAN_KERNEL(MulFSSE2, "sse2", f64, 2, LoadFSSE2, StoreFSSE2, _mm_mul_pd, Mul)
+	VMAN_KERNEL(MinFSSE2, "sse2", f64, 2, LoadFSSE2, StoreFSSE2, _mm_min_pd, Min)
+	VMAN_KERNEL(MaxFSSE2, "sse2", f64, 2, LoadFSSE2, StoreFSSE2, _mm_max_pd, Max)
+
+	VMAN_TARGET("sse2") s32 DotSSE2(const char* a, const char* b, std::size_t count) noexcept
+	{
+		__m128i sum = _mm_setzero_si128();
+		std::size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			sum = _mm_add_epi32(sum, MulSSE2(LoadSSE2(a + i * sizeof(s32)), LoadSSE2(b + i * sizeof(s32))));
+		}
+
+		s32 lanes[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+		return DotElements(a, b, i, count, SumLanes(lanes, 4));
+	}
+
+	// Four vectors of two doubles hold the eight interleaved sums.
+	VMAN_TARGET("sse2") f64 DotFSSE2(const char* a, const char* b, std::size_t count) noexcept
+	{
+		__m128d sums[4] = { _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd() };
+		const std::size_t full = count - count % DOT_LANES;
+		for (std::size_t i = 0; i < full; i += DOT_LANES)
+		{
+			for (std::size_t j = 0; j < 4; ++j)
+			{
+				const std::size_t offset = (i + j * 2) * sizeof(f64);
+				sums[j] = _mm_add_pd(sums[j], _mm_mul_pd(LoadFSSE2(a + offset), LoadFSSE2(b + offset)));
+			}
+		}
+
+		f64 lanes[DOT_LANES];
+		for (std::size_t j = 0; j < 4; ++j) _mm_storeu_pd(lanes + j * 2, sums[j]);
+		return FinishDot(lanes, a, b, full, count);
+	}
+
+	constexpr const VectorKernels SSE2 =
+	{
+		VectorLevel::SSE2,
+		&AddSSE2, &MulKernelSSE2, &MinKernelSSE2, &MaxKernelSSE2, &CompareSSE2, &MaskSSE2, &DotSSE2,
+		&AddFSSE2, &MulFSSE2, &MinFSSE2, &MaxFSSE2, &DotFSSE2
+	};
+
+	/*
+	 * AVX2, eight integers or four doubles at once.
+	**/
+	VMAN_TARGET("avx2") inline __m256i LoadAVX2(const char* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+	VMAN_TARGET("avx2") inline void StoreAVX2(char* p, __m256i v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+	VMAN_TARGET("avx2") inline __m256d LoadFAVX2(const char* p) noexcept { return _mm256_loadu_pd(reinterpret_cast<const double*>(p)); }
+	VMAN_TARGET("avx2") inline void StoreFAVX2(char* p, __m256d v) noexcept { _mm256_storeu_pd(reinterpret_cast<double*>(p), v); }
+	VMAN_TARGET("avx2") inline __m256i CompareOpAVX2(__m256i a, __m256i b) noexcept { return _mm256_cmpgt_epi32(b, a); }
+
+	VMAN_KERNEL(AddAVX2, "avx2", s32, 8, LoadAVX2, StoreAVX2, _mm256_add_epi32, Add)
+	VMAN_KERNEL(MulAVX2, "avx2", s32, 8, LoadAVX2, StoreAVX2, _mm256_mullo_epi32, Mul)
+	VMAN_KERNEL(MinAVX2, "avx2", s32, 8, LoadAVX2, StoreAVX2, _mm256_min_epi32, Min)
+	VMAN_KERNEL(MaxAVX2, "avx2", s32, 8, LoadAVX2, StoreAVX2, _mm256_max_epi32, Max)
+	VMAN_KERNEL(CompareAVX2, "avx2", s32, 8, LoadAVX2, StoreAVX2, CompareOpAVX2, Compare)
+	VMAN_KERNEL(MaskAVX2, "avx2", s32, 8, LoadAVX2, StoreAVX2, _mm256_and_si256, Mask)
+	VMAN_KERNEL(AddFAVX2, "avx2", f64, 4, LoadFAVX2, StoreFAVX2, _mm256_add_pd, Add)
+	VMAN_KERNEL(MulFAVX2, "avx2", f64, 4, LoadFAVX2, StoreFAVX2, _mm256_mul_pd, Mul)
+	VMAN_KERNEL(MinFAVX2, "avx2", f64, 4, LoadFAVX2, StoreFAVX2, _mm256_min_pd, Min)
+	VMAN_KERNEL(MaxFAVX2, "avx2", f64, 4, LoadFAVX2, StoreFAVX2, _mm256_max_pd, Max)
+
+	VMAN_TARGET("avx2") s32 DotAVX2(const char* a, const char* b, std::size_t count) noexcept
+	{
+		__m256i sum = _mm256_setzero_si256();
+		std::size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(LoadAVX2(a + i * sizeof(s32)), LoadAVX2(b + i * sizeof(s32))));
+		}
+
+		s32 lanes[8];
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+		return DotElements(a, b, i, count, SumLanes(lanes, 8));
+	}
+
+	VMAN_TARGET("avx2") f64 DotFAVX2(const char* a, const char* b, std::size_t count) noexcept
+	{
+		__m256d low = _mm256_setzero_pd();
+		__m256d high = _mm256_setzero_pd();
+		const std::size_t full = count - count % DOT_LANES;
+		for (std::size_t i = 0; i < full; i += DOT_LANES)
+		{
+			const std::size_t offset = i * sizeof(f64);
+			low = _mm256_add_pd(low, _mm256_mul_pd(LoadFAVX2(a + offset), LoadFAVX2(b + offset)));
+			high = _mm256_add_pd(high, _mm256_mul_pd(LoadFAVX2(a + offset + 32), LoadFAVX2(b + offset + 32)));
+		}
+
+		f64 lanes[DOT_LANES];
+		_mm256_storeu_pd(lanes, low);
+		_mm256_storeu_pd(lanes + 4, high);
+		return FinishDot(lanes, a, b, full, count);
+	}
+
+	constexpr const VectorKernels AVX2 =
+	{
+		VectorLevel::AVX2,
+		&AddAVX2, &MulAVX2, &MinAVX2, &MaxAVX2, &CompareAVX2, &MaskAVX2, &DotAVX2,
+		&AddFAVX2, &MulFAVX2, &MinFAVX2, &MaxFAVX2, &DotFAVX2
+	};
+
+	/*
+	 * AVX-512, only the foundation instructions are used. A whole vector of doubles holds the eight interleaved sums.
+	 * The headers of GCC start the unmasked minimum and maximum from an undefined vector, which -Wall reports.
+	**/
+#if defined (__GNUC__) && !defined (__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+	VMAN_TARGET("avx512f") inline __m512i LoadAVX512(const char* p) noexcept { return _mm512_loadu_si512(p); }
+	VMAN_TARGET("avx512f") inline void StoreAVX512(char* p, __m512i v) noexcept { _mm512_storeu_si512(p, v); }
+	VMAN_TARGET("avx512f") inline __m512d LoadFAVX512(const char* p) noexcept { return _mm512_loadu_pd(p); }
+	VMAN_TARGET("avx512f") inline void StoreFAVX512(char* p, __m512d v) noexcept { _mm512_storeu_pd(p, v); }
+
+	VMAN_TARGET("avx512f") inline __m512i CompareOpAVX512(__m512i a, __m512i b) noexcept
+	{
+		return _mm512_mask_set1_epi32(_mm512_setzero_si512(), _mm512_cmplt_epi32_mask(a, b), -1);
+	}
+
+	VMAN_KERNEL(AddAVX512, "avx512f", s32, 16, LoadAVX512, StoreAVX512, _mm512_add_epi32, Add)
+	VMAN_KERNEL(MulAVX512, "avx512f", s32, 16, LoadAVX512, StoreAVX512, _mm512_mullo_epi32, Mul)
+	VMAN_KERNEL(MinAVX512, "avx512f", s32, 16, LoadAVX512, StoreAVX512, _mm512_min_epi32, Min)
+	VMAN_KERNEL(MaxAVX512, "avx512f", s32, 16, LoadAVX512, StoreAVX512, _mm512_max_epi32, Max)
+	VMAN_KERNEL(CompareAVX512, "avx512f", s32, 16, LoadAVX512, StoreAVX512, CompareOpAVX512, Compare)
+	VMAN_KERNEL(MaskAVX512, "avx512f", s32, 16, LoadAVX512, StoreAVX512, _mm512_and_si512, Mask)
+	VMAN_KERNEL(AddFAVX512, "avx512f", f64, 8, LoadFAVX512, StoreFAVX512, _mm512_add_pd, Add)
+	VMAN_KERNEL(MulFAVX512, "avx512f", f64, 8, LoadFAVX512, StoreFAVX512, _mm512_mul_pd, Mul)
+	VMAN_KERNEL(MinFAVX512, "avx512f", f64, 8, LoadFAVX512, StoreFAVX512, _mm512_min_pd, Min)
+	VMAN_KERNEL(MaxFAVX512, "avx512f", f64, 8, LoadFAVX512, StoreFAVX512, _mm512_max_pd, Max)
+
+	VMAN_TARGET("avx512f") s32 DotAVX512(const char* a, const char* b, std::size_t count) noexcept
+	{
+		__m512i sum = _mm512_setzero_si512();
+		std::size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			sum = _mm512_add_epi32(sum, _mm512_mullo_epi32(LoadAVX512(a + i * sizeof(s32)), LoadAVX512(b + i * sizeof(s32))));
+		}
+
+		s32 lanes[16];
+		_mm512_storeu_si512(lanes, sum);
+		return DotElements(a, b, i, count, SumLanes(lanes, 16));
+	}
+
+	VMAN_TARGET("avx512f") f64 DotFAVX512(const char* a, const char* b, std::size_t count) noexcept
+	{
+		__m512d sum = _mm512_setzero_pd();
+		const std::size_t full = count - count % DOT_LANES;
+		for (std::size_t i = 0; i < full; i += DOT_LANES)
+		{
+			sum = _mm512_add_pd(sum, _mm512_mul_pd(LoadFAVX512(a + i * sizeof(f64)), LoadFAVX512(b + i * sizeof(f64))));
+		}
+
+		f64 lanes[DOT_LANES];
+		_mm512_storeu_pd(lanes, sum);
+		return FinishDot(lanes, a, b, full, count);
+	}
+
+#if defined (__GNUC__) && !defined (__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+	constexpr const VectorKernels AVX512 =
+	{
+		VectorLevel::AVX512,
+		&AddAVX512, &MulAVX512, &MinAVX512, &MaxAVX512, &CompareAVX512, &MaskAVX512, &DotAVX512,
+		&AddFAVX512, &MulFAVX512, &MinFAVX512, &MaxFAVX512, &DotFAVX512
+	};
+
+#undef VMAN_KERNEL
+#endif
+
+	VectorLevel Detect(void) noexcept
+	{
+#if VMAN_VECTOR_X86 && defined (__GNUC__)
+		// Both checks include the support of the operating system for the wider registers.
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f")) return VectorLevel::AVX512;
+		if (__builtin_cpu_supports("avx2")) return VectorLevel::AVX2;
+		return VectorLevel::SSE2;
+#elif VMAN_VECTOR_X86 && defined (_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx) return VectorLevel::SSE2;
+
+		// The operating system has to save the upper halves of the registers, and the mask and upper registers for AVX-512.
+		const unsigned long long enabled = _xgetbv(0);
+		if ((enabled & 0x06) != 0x06) return VectorLevel::SSE2;
+
+		__cpuidex(info, 7, 0);
+		if ((info[1] & (1 << 16)) != 0 && (enabled & 0xE6) == 0xE6) return VectorLevel::AVX512;
+		if ((info[1] & (1 << 5)) != 0) return VectorLevel::AVX2;
+		return VectorLevel::SSE2;
+#else
+		return VectorLevel::Scalar;
+#endif
+	}
+
+	std::atomic<const VectorKernels*> selected = nullptr;
+};
+
+VectorLevel vman::core::DetectVectorLevel(void) noexcept
+{
+	static const VectorLevel level = Detect();
+	return level;
+}
+
+const VectorKernels* vman::core::VectorKernelsFor(VectorLevel level) noexcept
+{
+	if (level > DetectVectorLevel()) return nullptr;
+
+	switch (level)
+	{
+#if VMAN_VECTOR_X86
+		case VectorLevel::SSE2: return &SSE2;
+		case VectorLevel::AVX2: return &AVX2;
+		case VectorLevel::AVX512: return &AVX512;
+#endif
+		case VectorLevel::Scalar: return &SCALAR;
+		default: return nullptr;
+	}
+}
+
+const VectorKernels& vman::core::ActiveVectorKernels(void) noexcept
+{
+	static const VectorKernels* const detected = VectorKernelsFor(DetectVectorLevel());
+
+	const VectorKernels* kernels = selected.load(std::memory_order_relaxed);
+	return kernels != nullptr ? *kernels : *detected;
+}
+
+bool vman::core::SelectVectorLevel(VectorLevel level) noexcept
+{
+	const VectorKernels* kernels = VectorKernelsFor(level);
+	if (kernels == nullptr) return false;
+
+	selected.store(kernels, std::memory_order_relaxed);
+	return true;
+}
+
+std::string_view vman::core::VectorLevelName(VectorLevel level) noexcept
+{
+	switch (level)
+	{
+		case VectorLevel::Scalar: return "scalar";
+		case VectorLevel::SSE2: return "sse2";
+		case VectorLevel::AVX2: return "avx2";
+		case VectorLevel::AVX512: return "avx512";
+		default: return {};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <cstddef>
+#include <string_view>
+
+#include "types.hpp"
+
+/*
+ * The kernels for SSE2, AVX2 and AVX-512 are compiled through target attributes, so the rest of the program
+ * doesn't need any special compiler flags. Which of them runs is decided by the CPU the program runs on.
+**/
+#if defined (__x86_64__) || defined (_M_X64)
+#define VMAN_VECTOR_X86 1
+#else
+#define VMAN_VECTOR_X86 0
+#endif
+
+namespace vman::core
+{
+	// The instruction sets the vector opcodes have kernels for, ordered from the slowest to the fastest.
+	enum class VectorLevel
+	{
+		Scalar,
+		SSE2,
+		AVX2,
+		AVX512
+	};
+
+	/*
+	 * The kernels of the vector opcodes for one instruction set. The buffers are byte pointers into the image,
+	 * they don't have to be aligned. Every level computes exactly the same results, the wider ones are only faster.
+	**/
+	struct VectorKernels
+	{
+		using Binary = void (*)(char* destination, const char* a, const char* b, std::size_t count);
+		using Dot = s32 (*)(const char* a, const char* b, std::size_t count);
+		using DotF = f64 (*)(const char* a, const char* b, std::size_t count);
+
+		VectorLevel level;
+
+		Binary add;
+		Binary mul;
+		Binary min;
+		Binary max;
+		Binary compare;
+		Binary mask;
+		Dot dot;
+
+		Binary addf;
+		Binary mulf;
+		Binary minf;
+		Binary maxf;
+		DotF dotf;
+	};
+
+	/*
+	 * The fastest level the CPU and the operating system support, detected once.
+	**/
+	VectorLevel DetectVectorLevel(void) noexcept;
+
+	/*
+	 * The kernels the vector opcodes use, the detected level unless SelectVectorLevel chose another one.
+	**/
+	const VectorKernels& ActiveVectorKernels(void) noexcept;
+
+	/*
+	 * The kernels of a level, nullptr if the level isn't supported by this build or this CPU.
+	**/
+	const VectorKernels* VectorKernelsFor(VectorLevel) noexcept;
+
+	/*
+	 * Makes the vector opcodes use the kernels of another level, mainly for benchmarks.
+	 * It must not be called while programs are running. Returns false if the level isn't supported.
+	**/
+	bool SelectVectorLevel(VectorLevel) noexcept;
+
+	std::string_view VectorLevelName(VectorLevel) noexcept;
+};
\ No newline at end of file
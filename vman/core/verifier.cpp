@@ -0,0 +1,270 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "verifier.hpp"
+
+using namespace vman;
+using namespace vman::core;
+
+namespace
+{
+	/*
+	 * What the verifier knows about a register at an instruction. Unreached registers haven't been seen on any path yet,
+	 * varying registers hold different values on different paths or a value that is only known at runtime.
+	**/
+	struct Value
+	{
+		enum Kind : u8 { Unreached, Constant, Varying };
+
+		Kind kind = Unreached;
+		s32 value = 0;
+
+		bool operator==(const Value& other) const noexcept { return kind == other.kind && (kind != Constant || value == other.value); }
+		bool operator!=(const Value& other) const noexcept { return !(*this == other); }
+	};
+
+	using State = std::array<Value, REGISTER_COUNT>;
+
+	Value Merge(const Value& a, const Value& b) noexcept
+	{
+		if (a.kind == Value::Unreached) return b;
+		if (b.kind == Value::Unreached || a == b) return a;
+		return { Value::Varying, 0 };
+	}
+
+	// Folds the operations that can't fail, everything else becomes varying.
+	Value Fold(u8 opcode, const Value& b, const Value& c) noexcept
+	{
+		if (b.kind != Value::Constant || (opcode != NOT && c.kind != Value::Constant)) return { Value::Varying, 0 };
+
+		const u32 x = static_cast<u32>(b.value);
+		const u32 y = static_cast<u32>(c.value);
+		switch (opcode)
+		{
+			case ADD: return { Value::Constant, static_cast<s32>(x + y) };
+			case SUB: return { Value::Constant, static_cast<s32>(x - y) };
+			case MUL: return { Value::Constant, static_cast<s32>(x * y) };
+			case AND: return { Value::Constant, static_cast<s32>(x & y) };
+			case OR: return { Value::Constant, static_cast<s32>(x | y) };
+			case XOR: return { Value::Constant, static_cast<s32>(x ^ y) };
+			case NOT: return { Value::Constant, static_cast<s32>(~x) };
+			default: return { Value::Varying, 0 };
+		}
+	}
+
+	bool ValidRegisters(const Instruction& ins)
+	{
+		const std::size_t used = RegisterOperands(OPCODES[ins.opcode].operands);
+
+		// The fourth register of the vector opcodes is kept in imm.
+		const u8 operands[] = { ins.a, ins.b, ins.c, static_cast<u8>(ins.imm) };
+		for (std::size_t i = 0; i < used; ++i)
+		{
+			if (operands[i] >= REGISTER_COUNT)
+			{
+				std::cerr << "[ERROR] Invalid register " << static_cast<int>(operands[i]) << " at 0x" << std::hex << ins.address << std::dec << ".\n";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	u8 TargetRegister(const Instruction& ins) noexcept
+	{
+		return ins.opcode == JMP ? ins.a : ins.c;
+	}
+
+	/*
+	 * Computes the register values at the start of every instruction. Jumps with an unknown target could continue anywhere,
+	 * if there is one, every instruction is treated as a possible target with every register varying.
+	 * Returns false in that case, as the analysis has to start over with all instructions as entry points.
+	**/
+	bool Propagate(const Program& program, std::vector<State>& states, bool everywhere)
+	{
+		const std::size_t count = program.code.size();
+		const State varying = [] { State state; state.fill({ Value::Varying, 0 }); return state; }();
+
+		states.assign(count, State());
+		std::vector<u32> worklist;
+		std::vector<bool> queued(count, false);
+
+		/*
+		 * Registers can be set by the embedder before the program runs, so nothing is known at the entry point.
+		**/
+		for (u32 i = 0; i < count; ++i)
+		{
+			if (!everywhere && i != program.entry) continue;
+
+			states[i] = varying;
+			worklist.push_back(i);
+			queued[i] = true;
+		}
+
+		auto flow = [&](u32 index, const State& state)
+		{
+			bool changed = false;
+			for (std::size_t r = 0; r < REGISTER_COUNT; ++r)
+			{
+				const Value merged = Merge(states[index][r], state[r]);
+				changed |= merged != states[index][r];
+				states[index][r] = merged;
+			}
+
+			if (changed && !queued[index])
+			{
+				worklist.push_back(index);
+				queued[index] = true;
+			}
+		};
+
+		while (!worklist.empty())
+		{
+			const u32 index = worklist.back();
+			worklist.pop_back();
+			queued[index] = false;
+
+			const Instruction& ins = program.code[index];
+			State state = states[index];
+
+			switch (ins.opcode)
+			{
+				case HALT:
+					continue;
+
+				case MOV:
+					state[ins.a] = { Value::Constant, ins.imm };
+					break;
+
+				case ADD:
+				case SUB:
+				case DIV:
+				case MUL:
+				case MOD:
+				case LSH:
+				case RSH:
+				case AND:
+				case OR:
+				case XOR:
+					state[ins.a] = Fold(ins.opcode, state[ins.b], state[ins.c]);
+					break;
+
+				case NOT:
+					state[ins.a] = Fold(NOT, state[ins.b], state[ins.b]);
+					break;
+
+				case NFC:
+				case NFCI:
+					// The result of the native function is written into register 2.
+					state[2] = { Value::Varying, 0 };
+					break;
+
+				case CMPX:
+				case CMPF:
+				case TRUNC:
+				case VDOT:
+				case LOAD8:
+				case LOAD8S:
+				case LOAD16:
+				case LOAD16S:
+				case LOAD32:
+				case MEMCMP:
+					// Only the r registers are tracked, these take their value from the other banks, from buffers or from memory.
+					state[ins.a] = { Value::Varying, 0 };
+					break;
+
+				case JMP:
+				case JIE:
+				case JNE:
+				{
+					const Value& target = state[TargetRegister(ins)];
+					const u32 targetIndex = target.kind == Value::Constant ? program.IndexOf(static_cast<u32>(target.value)) : INVALID_INDEX;
+
+					if (target.kind == Value::Varying && !everywhere) return false;
+					if (targetIndex != INVALID_INDEX) flow(targetIndex, state);
+					if (ins.opcode == JMP) continue;
+				} break;
+			}
+
+			flow(index + 1, state);
+		}
+		return true;
+	}
+
+	/*
+	 * Returns true if the register always points to a value of the given type inside the binary.
+	**/
+	bool PointsIntoImage(const Value& value, int type, const Image& fileBytes) noexcept
+	{
+		// Values that are passed in the x and f registers don't point anywhere.
+		if (type & vmb::Bridge::VMBREGISTER) return true;
+		if (value.kind != Value::Constant || value.value < 0) return false;
+
+		return static_cast<std::size_t>(value.value) + vmb::Bridge::ValueSize(type) <= fileBytes.size();
+	}
+};
+
+bool vman::core::Verify(Program& program, const Image& fileBytes)
+{
+	for (const Instruction& ins : program.code)
+	{
+		if (!ValidRegisters(ins)) return false;
+	}
+
+	std::vector<State> states;
+	if (!Propagate(program, states, false)) Propagate(program, states, true);
+
+	// Several NFCI can share the call site of their import, it is only verified if all of them are.
+	for (CallSite& site : program.callSites) site.verified = true;
+
+	for (u32 i = 0; i < program.code.size(); ++i)
+	{
+		Instruction& ins = program.code[i];
+		const State& state = states[i];
+
+		switch (ins.opcode)
+		{
+			case JMP:
+			case JIE:
+			case JNE:
+			{
+				/*
+				 * A constant target that isn't the start of an instruction stays unresolved,
+				 * the jump raises its exception at runtime, if it is ever taken.
+				**/
+				const Value& target = state[TargetRegister(ins)];
+				ins.imm = static_cast<s32>(target.kind == Value::Constant ? program.IndexOf(static_cast<u32>(target.value)) : INVALID_INDEX);
+			} break;
+
+			case NFC:
+			case NFCI:
+			{
+				CallSite& site = program.callSites[ins.imm];
+				for (u8 p = 0; p < site.paramCount; ++p)
+				{
+					site.verified &= PointsIntoImage(state[p + 2], site.paramTypes[p], fileBytes);
+				}
+			} break;
+		}
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <array>
+#include <vector>
+#include <iostream>
+
+#include "types.hpp"
+#include "opcodes.hpp"
+#include "image.hpp"
+#include "decoder.hpp"
+#include "../vmb/vmb.hpp"
+
+namespace vman::core
+{
+	/*
+	 * Checks a decoded program once while it gets loaded, so the interpreter loop can run it without any checks:
+	 *
+	 * - Every register operand has to be one of the 12 registers, otherwise the program is rejected.
+	 * - The values of the registers are followed through the program by constant propagation. Jumps whose target
+	 *   register always holds the same valid address at the jump get their target index stored in the instruction,
+	 *   only the remaining jumps look up and check their target at runtime.
+	 * - NFC and NFCI call sites whose parameter registers always point into the binary, with enough room for the value,
+	 *   are marked as verified, the others check their parameters on every call.
+	 *
+	 * Truncated instructions are already rejected by the decoder.
+	**/
+	bool Verify(Program&, const Image&);
+};
\ No newline at end of file
@@ -3,7 +3,11 @@
 
 #include "vman.h"
 #include "core/interpreter.hpp"
+#include "core/batch.hpp"
+#include "asm/asm.hpp"
 #include "asm/disasm.hpp"
+#include "aot/aot.hpp"
+#include "bench/bench.hpp"
 
 
 using namespace std;
@@ -24,19 +28,141 @@ int main(int argc, char* argv[])
 		if (strcmp(argv[1], "-e") == 0)
 		{
 			vman::core::InterpreterContext context;
-			context.OpenFile(argv[2]);
-			context.Execute();
-			return 0;
+			vman::core::Batch batch;
+			bool manifest = false;
+			std::size_t jobs = 0;
+
+			for (int i = 2; i < argc; ++i)
+			{
+				if (strncmp(argv[i], "--", 2) != 0) batch.Add(argv[i]);
+				else if (strcmp(argv[i], "--dispatch=switch") == 0) context.SetDispatch(vman::core::Dispatch::Switch);
+				else if (strcmp(argv[i], "--dispatch=threaded") == 0) context.SetDispatch(vman::core::Dispatch::Threaded);
+				else if (strcmp(argv[i], "--dispatch=jit") == 0) context.SetDispatch(vman::core::Dispatch::Jit);
+				else if (strcmp(argv[i], "--registers=pinned") == 0) context.SetPinRegisters(true);
+				else if (strcmp(argv[i], "--registers=memory") == 0) context.SetPinRegisters(false);
+				else if (strcmp(argv[i], "--no-fuse") == 0) context.SetFusion(false);
+				else if (strcmp(argv[i], "--profile") == 0) context.SetProfiling(true);
+				else if (strncmp(argv[i], "--manifest=", 11) == 0)
+				{
+					if (!batch.AddManifest(argv[i] + 11)) return -1;
+					manifest = true;
+				}
+				else if (strncmp(argv[i], "--jobs=", 7) == 0) jobs = strtoul(argv[i] + 7, nullptr, 10);
+				else std::cerr << "Unknown option: " << argv[i] << "\n";
+			}
+
+			if (batch.Files().empty())
+			{
+				std::cerr << "No file passed. USAGE: vman -e file.bin\n";
+				return -1;
+			}
+
+			if (batch.Files().size() == 1 && !manifest)
+			{
+				if (!context.OpenFile(batch.Files()[0])) return -1;
+
+				// The console window stays open until the exception has been read.
+				if (context.Execute() == vman::core::EXECUTION_FAILED)
+				{
+					while (!getchar());
+					return -1;
+				}
+				return 0;
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			const std::size_t failed = batch.Run(context, jobs);
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+			std::cout << "[BATCH] Ran " << batch.Files().size() - failed << " of " << batch.Files().size() << " binaries in " << elapsed.count() << " ms.\n";
+			return failed == 0 ? 0 : -1;
+		}
+		else if (strcmp(argv[1], "-b") == 0)
+		{
+			vman::bench::Options options;
+
+			for (int i = 2; i < argc; ++i)
+			{
+				if (strncmp(argv[i], "--json=", 7) == 0) options.jsonPath = argv[i] + 7;
+				else if (strncmp(argv[i], "--filter=", 9) == 0) options.filter = argv[i] + 9;
+				else if (strncmp(argv[i], "--repetitions=", 14) == 0) options.repetitions = std::max(1, atoi(argv[i] + 14));
+				else std::cerr << "Unknown option: " << argv[i] << "\n";
+			}
+
+			return vman::bench::Run(options);
+		}
+		else if (strcmp(argv[1], "-a") == 0)
+		{
+			if (argc < 3)
+			{
+				std::cerr << "No file passed. USAGE: vman -a source.asm [output.bin]\n";
+				return -1;
+			}
+
+			const std::string output = argc > 3 ? argv[3] : std::filesystem::path(argv[2]).replace_extension(".bin").string();
+
+			const auto start = std::chrono::steady_clock::now();
+			vasm::Assembler assembler;
+			if (!assembler.AssembleFile(argv[2], output)) return -1;
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+			std::cout << "[ASM] Assembled " << assembler.Binary().size() << " bytes into " << output << " in " << elapsed.count() << " ms.\n";
+		}
+		else if (strcmp(argv[1], "-c") == 0)
+		{
+			if (argc < 3)
+			{
+				std::cerr << "No file passed. USAGE: vman -c program.bin [program.c]\n";
+				return -1;
+			}
+
+			const std::string output = argc > 3 ? argv[3] : std::filesystem::path(argv[2]).replace_extension(".c").string();
+
+			vman::aot::Translator translator;
+			if (!translator.TranslateFile(argv[2], output)) return -1;
+
+			std::cout << "[AOT] Translated " << argv[2] << " into " << output << ", build it with \"cc -O2 -shared -fPIC "
+				<< output << " -o " << std::filesystem::path(output).replace_extension(".so").string() << "\" and run the library with vman -e.\n";
 		}
 		else if (strcmp(argv[1], "-d") == 0)
 		{
+			if (argc < 3)
+			{
+				std::cerr << "No file passed. USAGE: vman -d file.bin\n";
+				return -1;
+			}
+
 			vasm::Disassembler disasm(argv[2]);
+
+			for (int i = 3; i < argc; ++i)
+			{
+				if (strcmp(argv[i], "--color") == 0) disasm.SetColor(true);
+				else if (strcmp(argv[i], "--no-color") == 0) disasm.SetColor(false);
+				else if (strncmp(argv[i], "--jobs=", 7) == 0) disasm.SetThreads(strtoul(argv[i] + 7, nullptr, 10));
+				else std::cerr << "Unknown option: " << argv[i] << "\n";
+			}
+
 			disasm.Disassemble();
 		}
 		else if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)
 		{
 			std::cout << "USAGE: vman -e \"fileName.bin\" - Execute a virtual man compatible binary file.\n";
+			std::cout << "USAGE: vman -e \"a.bin\" \"b.bin\" ... - Execute several binaries in one process, spread over all cores.\n";
 			std::cout << "USAGE: vman -d \"fileName.bin\" - Disassemble a virtual man compatible binary file.\n";
+			std::cout << "USAGE: vman -a \"source.asm\" [\"output.bin\"] - Assemble a source file, the output is named after the source by default.\n";
+			std::cout << "USAGE: vman -c \"program.bin\" [\"program.c\"] - Translate a binary into C, compiled as a shared library it runs natively through vman -e.\n";
+			std::cout << "USAGE: vman -b - Run the interpreter benchmarks.\n";
+			std::cout << "OPTIONS for -e: --dispatch=switch, --dispatch=threaded, --dispatch=jit - Select the execution engine.\n";
+			std::cout << "OPTIONS for -e: --registers=pinned, --registers=memory - Keep the registers local to the interpreter loop or access them through memory.\n";
+			std::cout << "OPTIONS for -e: --no-fuse - Don't fuse frequent instruction pairs into superinstructions.\n";
+			std::cout << "OPTIONS for -e: --profile - Count executions and cycles per opcode, hot instructions, native calls and opcode pairs and print them at exit.\n";
+			std::cout << "OPTIONS for -e: --manifest=list.txt - Execute every binary listed in the file, one path per line.\n";
+			std::cout << "OPTIONS for -e: --jobs=N - Number of threads for several binaries, every hardware thread by default.\n";
+			std::cout << "OPTIONS for -d: --color, --no-color - Force colored output on or off, it is only colored on a terminal by default.\n";
+			std::cout << "OPTIONS for -d: --jobs=N - Format the instructions on N threads, the output stays in order.\n";
+			std::cout << "OPTIONS for -b: --json=results.json - Write the results of the benchmark suite to a JSON file.\n";
+			std::cout << "OPTIONS for -b: --filter=name - Only run the workloads whose name contains the text (arithmetic, branch, mov, nfc, import, vector, memory, bulk).\n";
+			std::cout << "OPTIONS for -b: --repetitions=N - Keep the fastest of N runs for every measurement, 5 by default.\n";
 		}
 		else
 		{
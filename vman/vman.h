@@ -3,6 +3,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 // TODO: Verweisen Sie hier auf zusätzliche Header, die Ihr Programm erfordert.
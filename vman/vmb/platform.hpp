@@ -0,0 +1,94 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Everything VirtualMAN needs from the operating system.
+ * platform_win32.cpp implements it through the Windows API, platform_posix.cpp through dlopen,
+ * only the implementation for the target gets compiled, the other one is empty.
+**/
+namespace vman::vmb::platform
+{
+	struct Module
+	{
+		std::string name;
+		void* base;
+	};
+
+	/*
+	 * Returns the handle of a library, the library gets loaded if it isn't loaded yet.
+	 * Libraries stay loaded until the process ends, so resolved functions never become invalid.
+	**/
+	void* LoadModule(const char* name) noexcept;
+
+	/*
+	 * Returns the address of a function inside a library, nullptr if either of them can't be found.
+	**/
+	void* FindSymbol(const char* libName, const char* funcName) noexcept;
+
+	/*
+	 * A file that has been mapped into memory through MapFile.
+	**/
+	struct MappedFile
+	{
+		char* data;
+		std::size_t size;
+	};
+
+	/*
+	 * Maps a whole file into memory, read only. Every process that maps the same file shares its pages with the page cache,
+	 * a write into the mapping faults instead of silently copying the page. Empty files are mapped without data.
+	 * Returns false if the file can't be opened or mapped.
+	**/
+	bool MapFile(const char* path, MappedFile& file) noexcept;
+	void UnmapFile(MappedFile& file) noexcept;
+
+	/*
+	 * Reserves address space without any memory behind it, every access faults until CommitMemory makes a part
+	 * of it readable and writable. Committed pages start zeroed. Returns nullptr if the address space is exhausted.
+	**/
+	void* ReserveMemory(std::size_t size) noexcept;
+	bool CommitMemory(void* address, std::size_t size) noexcept;
+	void ReleaseMemory(void* address, std::size_t size) noexcept;
+
+	/*
+	 * Calls the function, if it faults on an address inside the given range, it gets abandoned through a long jump
+	 * and GuardedCall returns false with the faulting address. Faults anywhere else crash the process as they always did.
+	 * Nothing on the stack of the function gets destroyed when it's abandoned, so it mustn't own anything at that point.
+	**/
+	bool GuardedCall(void (*function)(void*), void* context, const void* begin, std::size_t size, std::uintptr_t& fault);
+
+	// Every library that is currently loaded into the process.
+	std::vector<Module> LoadedModules(void);
+
+	unsigned long ProcessId(void) noexcept;
+
+	// Returns true if the standard output is a terminal and not redirected into a file or a pipe.
+	bool OutputIsTerminal(void) noexcept;
+};
\ No newline at end of file
@@ -0,0 +1,229 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "platform.hpp"
+
+#if !defined (_WIN32)
+
+#include <mutex>
+#include <csetjmp>
+#include <csignal>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined (__APPLE__)
+#include <mach-o/dyld.h>
+#else
+#include <link.h>
+#endif
+
+void* vman::vmb::platform::LoadModule(const char* name) noexcept
+{
+	return dlopen(name, RTLD_NOW | RTLD_GLOBAL);
+}
+
+void* vman::vmb::platform::FindSymbol(const char* libName, const char* funcName) noexcept
+{
+	/*
+	 * Binaries written for Windows name libraries like User32.dll, which don't exist here.
+	 * Functions of libraries that can't be loaded are searched in everything the process already has loaded,
+	 * this finds the C library functions no matter how the library is called.
+	**/
+	void* handle = LoadModule(libName);
+	return dlsym(handle != nullptr ? handle : RTLD_DEFAULT, funcName);
+}
+
+bool vman::vmb::platform::MapFile(const char* path, MappedFile& file) noexcept
+{
+	file = { nullptr, 0 };
+
+	const int fd = open(path, O_RDONLY);
+	if (fd == -1) return false;
+
+	struct stat status;
+	if (fstat(fd, &status) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	if (status.st_size > 0)
+	{
+		void* memory = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (memory == MAP_FAILED)
+		{
+			close(fd);
+			return false;
+		}
+		file = { static_cast<char*>(memory), static_cast<std::size_t>(status.st_size) };
+	}
+
+	// The mapping stays valid after the file has been closed.
+	close(fd);
+	return true;
+}
+
+void vman::vmb::platform::UnmapFile(MappedFile& file) noexcept
+{
+	if (file.data != nullptr) munmap(file.data, file.size);
+	file = { nullptr, 0 };
+}
+
+void* vman::vmb::platform::ReserveMemory(std::size_t size) noexcept
+{
+	void* memory = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return memory != MAP_FAILED ? memory : nullptr;
+}
+
+bool vman::vmb::platform::CommitMemory(void* address, std::size_t size) noexcept
+{
+	return size == 0 || mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void vman::vmb::platform::ReleaseMemory(void* address, std::size_t size) noexcept
+{
+	if (address != nullptr) munmap(address, size);
+}
+
+namespace
+{
+	/*
+	 * The innermost GuardedCall of a thread, a native function can run another program, so guards can be nested.
+	**/
+	struct Guard
+	{
+		const char* begin;
+		std::size_t size;
+		std::uintptr_t fault;
+		Guard* previous;
+		sigjmp_buf jump;
+	};
+
+	thread_local Guard* activeGuard = nullptr;
+
+	struct sigaction previousSegv;
+	struct sigaction previousBus;
+
+	void FaultHandler(int signal, siginfo_t* info, void* context)
+	{
+		Guard* guard = activeGuard;
+		const char* address = static_cast<const char*>(info->si_addr);
+
+		if (guard != nullptr && address >= guard->begin && address < guard->begin + guard->size)
+		{
+			guard->fault = reinterpret_cast<std::uintptr_t>(address);
+			siglongjmp(guard->jump, 1);
+		}
+
+		/*
+		 * Not a fault inside a guarded range, it goes to the handler that was installed before, which may handle it
+		 * and return. This handler stays installed, so later faults inside guarded ranges are still caught.
+		 * Without a previous handler the default action is restored and the access faults again once this returns.
+		**/
+		const struct sigaction& previous = signal == SIGBUS ? previousBus : previousSegv;
+		if ((previous.sa_flags & SA_SIGINFO) != 0 && previous.sa_sigaction != nullptr)
+		{
+			previous.sa_sigaction(signal, info, context);
+		}
+		else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN)
+		{
+			previous.sa_handler(signal);
+		}
+		else
+		{
+			::signal(signal, SIG_DFL);
+		}
+	}
+};
+
+bool vman::vmb::platform::GuardedCall(void (*function)(void*), void* context, const void* begin, std::size_t size, std::uintptr_t& fault)
+{
+	/*
+	 * SA_NODEFER keeps the signal unblocked after the long jump, so the signal mask doesn't have to be saved for every call.
+	 * macOS reports accesses to reserved pages as SIGBUS, Linux as SIGSEGV.
+	**/
+	static std::once_flag installed;
+	std::call_once(installed, []
+	{
+		struct sigaction action = {};
+		action.sa_sigaction = &FaultHandler;
+		action.sa_flags = SA_SIGINFO | SA_NODEFER;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGSEGV, &action, &previousSegv);
+		sigaction(SIGBUS, &action, &previousBus);
+	});
+
+	Guard guard = { static_cast<const char*>(begin), size, 0, activeGuard, {} };
+	activeGuard = &guard;
+
+	if (sigsetjmp(guard.jump, 0) != 0)
+	{
+		activeGuard = guard.previous;
+		fault = guard.fault;
+		return false;
+	}
+
+	function(context);
+	activeGuard = guard.previous;
+	return true;
+}
+
+std::vector<vman::vmb::platform::Module> vman::vmb::platform::LoadedModules(void)
+{
+	std::vector<Module> modules;
+
+#if defined (__APPLE__)
+	for (uint32_t i = 0; i < _dyld_image_count(); ++i)
+	{
+		modules.push_back({ _dyld_get_image_name(i), const_cast<void*>(static_cast<const void*>(_dyld_get_image_header(i))) });
+	}
+#else
+	dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data)
+	{
+		// The main program has an empty name.
+		if (info->dlpi_name != nullptr && info->dlpi_name[0] != '\0')
+		{
+			static_cast<std::vector<Module>*>(data)->push_back({ info->dlpi_name, reinterpret_cast<void*>(info->dlpi_addr) });
+		}
+		return 0;
+	}, &modules);
+#endif
+
+	return modules;
+}
+
+unsigned long vman::vmb::platform::ProcessId(void) noexcept
+{
+	return static_cast<unsigned long>(getpid());
+}
+
+bool vman::vmb::platform::OutputIsTerminal(void) noexcept
+{
+	return isatty(STDOUT_FILENO) != 0;
+}
+
+#endif // !_WIN32
\ No newline at end of file
@@ -0,0 +1,201 @@
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include "platform.hpp"
+
+#if defined (_WIN32)
+
+#include <Windows.h>
+#include <Psapi.h>
+#include <io.h>
+#include <mutex>
+#include <csetjmp>
+#include <cstdio>
+
+void* vman::vmb::platform::LoadModule(const char* name) noexcept
+{
+	HMODULE hModule = GetModuleHandleA(name);
+	if (hModule == nullptr) hModule = LoadLibraryA(name);
+	return reinterpret_cast<void*>(hModule);
+}
+
+void* vman::vmb::platform::FindSymbol(const char* libName, const char* funcName) noexcept
+{
+	HMODULE hModule = static_cast<HMODULE>(LoadModule(libName));
+	if (hModule == nullptr) return nullptr;
+
+	return reinterpret_cast<void*>(GetProcAddress(hModule, funcName));
+}
+
+bool vman::vmb::platform::MapFile(const char* path, MappedFile& file) noexcept
+{
+	file = { nullptr, 0 };
+
+	HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size))
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+
+	if (size.QuadPart > 0)
+	{
+		HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (hMapping == nullptr)
+		{
+			CloseHandle(hFile);
+			return false;
+		}
+
+		void* memory = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+		// The view keeps the mapping and the file alive on its own.
+		CloseHandle(hMapping);
+		if (memory == nullptr)
+		{
+			CloseHandle(hFile);
+			return false;
+		}
+		file = { static_cast<char*>(memory), static_cast<std::size_t>(size.QuadPart) };
+	}
+
+	CloseHandle(hFile);
+	return true;
+}
+
+void vman::vmb::platform::UnmapFile(MappedFile& file) noexcept
+{
+	if (file.data != nullptr) UnmapViewOfFile(file.data);
+	file = { nullptr, 0 };
+}
+
+void* vman::vmb::platform::ReserveMemory(std::size_t size) noexcept
+{
+	return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+bool vman::vmb::platform::CommitMemory(void* address, std::size_t size) noexcept
+{
+	return size == 0 || VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+void vman::vmb::platform::ReleaseMemory(void* address, std::size_t) noexcept
+{
+	if (address != nullptr) VirtualFree(address, 0, MEM_RELEASE);
+}
+
+namespace
+{
+	/*
+	 * The innermost GuardedCall of a thread, a native function can run another program, so guards can be nested.
+	**/
+	struct Guard
+	{
+		const char* begin;
+		std::size_t size;
+		std::uintptr_t fault;
+		Guard* previous;
+		jmp_buf jump;
+	};
+
+	thread_local Guard* activeGuard = nullptr;
+
+	LONG CALLBACK FaultHandler(EXCEPTION_POINTERS* exception)
+	{
+		const EXCEPTION_RECORD* record = exception->ExceptionRecord;
+		Guard* guard = activeGuard;
+
+		// The second parameter of an access violation is the address that couldn't be accessed.
+		if (guard != nullptr && record->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && record->NumberParameters >= 2)
+		{
+			const char* address = reinterpret_cast<const char*>(record->ExceptionInformation[1]);
+			if (address >= guard->begin && address < guard->begin + guard->size)
+			{
+				guard->fault = reinterpret_cast<std::uintptr_t>(address);
+				longjmp(guard->jump, 1);
+			}
+		}
+		return EXCEPTION_CONTINUE_SEARCH;
+	}
+};
+
+bool vman::vmb::platform::GuardedCall(void (*function)(void*), void* context, const void* begin, std::size_t size, std::uintptr_t& fault)
+{
+	static std::once_flag installed;
+	std::call_once(installed, [] { AddVectoredExceptionHandler(1, &FaultHandler); });
+
+	Guard guard = { static_cast<const char*>(begin), size, 0, activeGuard, {} };
+	activeGuard = &guard;
+
+	if (setjmp(guard.jump) != 0)
+	{
+		activeGuard = guard.previous;
+		fault = guard.fault;
+		return false;
+	}
+
+	function(context);
+	activeGuard = guard.previous;
+	return true;
+}
+
+std::vector<vman::vmb::platform::Module> vman::vmb::platform::LoadedModules(void)
+{
+	std::vector<Module> modules;
+
+	HANDLE hProc = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, GetCurrentProcessId());
+	if (hProc == nullptr) return modules;
+
+	HMODULE hMods[1024];
+	DWORD cbNeeded;
+
+	if (EnumProcessModules(hProc, hMods, sizeof(hMods), &cbNeeded))
+	{
+		for (DWORD j = 0; j < (cbNeeded / sizeof(HMODULE)); ++j)
+		{
+			char szModName[MAX_PATH];
+			if (GetModuleBaseNameA(hProc, hMods[j], szModName, sizeof(szModName)))
+			{
+				modules.push_back({ szModName, reinterpret_cast<void*>(hMods[j]) });
+			}
+		}
+	}
+
+	CloseHandle(hProc);
+	return modules;
+}
+
+unsigned long vman::vmb::platform::ProcessId(void) noexcept
+{
+	return GetCurrentProcessId();
+}
+
+bool vman::vmb::platform::OutputIsTerminal(void) noexcept
+{
+	return _isatty(_fileno(stdout)) != 0;
+}
+
+#endif // _WIN32
\ No newline at end of file
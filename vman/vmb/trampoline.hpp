@@ -0,0 +1,137 @@
+#pragma once
+
+/*
+ * Copyright  2022 PHTNC<>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the Software), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+**/
+
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "../core/types.hpp"
+#include "vmb.hpp"
+
+/*
+ * Direct calls for the most common signatures of native functions, they skip the dyncall VM entirely.
+ * Only vmb.cpp includes this, so the trampolines get instantiated in a single translation unit.
+**/
+namespace vman::vmb
+{
+	using Trampoline = Bridge::CallPlan::Direct;
+
+	/*
+	 * Signatures with up to this many int, long long and pointer parameters get a trampoline, that makes
+	 * 121 signatures for each return type, which is either void, int, long long, double or a pointer.
+	 * Smaller integers are left to dyncall, their calling conventions differ in how the upper bits are extended.
+	**/
+	constexpr const std::size_t MAX_TRAMPOLINE_PARAMS = 4;
+
+	namespace trampoline
+	{
+		// Values inside the binary don't have to be aligned, so they are copied out instead of dereferenced.
+		template<class T>
+		T Value(const void* value) noexcept
+		{
+			if constexpr (std::is_pointer_v<T>)
+			{
+				return const_cast<void*>(value);
+			}
+			else
+			{
+				T result;
+				memcpy(&result, value, sizeof(T));
+				return result;
+			}
+		}
+
+		template<class R>
+		Bridge::Result Result(R value) noexcept
+		{
+			if constexpr (std::is_pointer_v<R>) return { static_cast<s64>(reinterpret_cast<std::uintptr_t>(value)), 0.0 };
+			else if constexpr (std::is_floating_point_v<R>) return { Truncate(value), value };
+			else return { static_cast<s64>(value), 0.0 };
+		}
+
+		template<class R, class... A, std::size_t... I>
+		Bridge::Result Invoke(void* funcPtr, const void* const* values, std::index_sequence<I...>) noexcept
+		{
+			const auto function = reinterpret_cast<R (*)(A...)>(funcPtr);
+			if constexpr (std::is_void_v<R>)
+			{
+				function(Value<A>(values[I])...);
+				return { 0, 0.0 };
+			}
+			else
+			{
+				return Result<R>(function(Value<A>(values[I])...));
+			}
+		}
+
+		template<class R, class... A>
+		Bridge::Result Call(void* funcPtr, const void* const* values) noexcept
+		{
+			return Invoke<R, A...>(funcPtr, values, std::index_sequence_for<A...>{});
+		}
+
+		/*
+		 * Walks the parameter types and picks the instantiation of Call with exactly these C++ types.
+		 * Every instantiation is generated at compile time, a plan only chooses one of them.
+		**/
+		template<class R, class... A>
+		Trampoline Select(const u8* paramTypes, std::size_t remaining) noexcept
+		{
+			if (remaining == 0) return &Call<R, A...>;
+
+			if constexpr (sizeof...(A) < MAX_TRAMPOLINE_PARAMS)
+			{
+				switch (paramTypes[0])
+				{
+				case Bridge::VMBINT: return Select<R, A..., int>(paramTypes + 1, remaining - 1);
+				case Bridge::VMBLONG_LONG: return Select<R, A..., long long>(paramTypes + 1, remaining - 1);
+				case Bridge::VMBPOINTER: return Select<R, A..., void*>(paramTypes + 1, remaining - 1);
+				default: break;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	/*
+	 * Returns the trampoline for a signature, nullptr if the call has to go through dyncall.
+	**/
+	inline Trampoline SelectTrampoline(int returnType, const u8* paramTypes, std::size_t paramCount) noexcept
+	{
+		if (paramCount > MAX_TRAMPOLINE_PARAMS) return nullptr;
+
+		switch (returnType)
+		{
+		case Bridge::VMBVOID: return trampoline::Select<void>(paramTypes, paramCount);
+		case Bridge::VMBINT: return trampoline::Select<int>(paramTypes, paramCount);
+		case Bridge::VMBLONG_LONG: return trampoline::Select<long long>(paramTypes, paramCount);
+		case Bridge::VMBDOUBLE: return trampoline::Select<double>(paramTypes, paramCount);
+		case Bridge::VMBPOINTER: return trampoline::Select<void*>(paramTypes, paramCount);
+		default: return nullptr;
+		}
+	}
+};
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "vmb.hpp"
+#include "trampoline.hpp"
 
 /*
  * Copyright  2022 PHTNC<>
@@ -35,10 +36,95 @@ vman::vmb::Bridge::Bridge(void)
 		std::cerr << "[ERROR] Failed to allocate memory for bridge component.\n";
 		exit(-2);
 	}
-	hProc = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, GetCurrentProcessId());;
 }
 
 vman::vmb::Bridge::~Bridge(void)
 {
 	dcFree(vm);
+}
+
+void* vman::vmb::Bridge::ResolveSymbol(CCCSTR libName, CCCSTR funcName) noexcept
+{
+	return platform::FindSymbol(libName, funcName);
+}
+
+namespace
+{
+	using vman::vmb::Bridge;
+
+	Bridge::Result Integer(vman::s64 value) noexcept { return { value, 0.0 }; }
+	Bridge::Result Real(vman::f64 value) noexcept { return { vman::vmb::Truncate(value), value }; }
+
+	vman::s64 Wide(const void* value) noexcept { return *static_cast<const vman::s64*>(value); }
+	vman::f64 Float(const void* value) noexcept { return *static_cast<const vman::f64*>(value); }
+
+	/*
+	 * Pushes a value of an x or f register, it gets converted to the type of the parameter.
+	**/
+	Bridge::CallPlan::Pusher RegisterPusher(int type) noexcept
+	{
+		switch (type)
+		{
+		case Bridge::VMBCHAR: return [](DCCallVM* vm, const void* value) { dcArgChar(vm, static_cast<char>(Wide(value))); };
+		case Bridge::VMBBOOL: return [](DCCallVM* vm, const void* value) { dcArgBool(vm, Wide(value) != 0); };
+		case Bridge::VMBSHORT: return [](DCCallVM* vm, const void* value) { dcArgShort(vm, static_cast<short>(Wide(value))); };
+		case Bridge::VMBINT: return [](DCCallVM* vm, const void* value) { dcArgInt(vm, static_cast<int>(Wide(value))); };
+		case Bridge::VMBLONG: return [](DCCallVM* vm, const void* value) { dcArgLong(vm, static_cast<long>(Wide(value))); };
+		case Bridge::VMBLONG_LONG: return [](DCCallVM* vm, const void* value) { dcArgLongLong(vm, Wide(value)); };
+		case Bridge::VMBFLOAT: return [](DCCallVM* vm, const void* value) { dcArgFloat(vm, static_cast<float>(Float(value))); };
+		case Bridge::VMBDOUBLE: return [](DCCallVM* vm, const void* value) { dcArgDouble(vm, Float(value)); };
+		case Bridge::VMBPOINTER:
+		default: return [](DCCallVM* vm, const void* value) { dcArgPointer(vm, reinterpret_cast<void*>(static_cast<std::uintptr_t>(Wide(value)))); };
+		}
+	}
+};
+
+vman::vmb::Bridge::CallPlan vman::vmb::Bridge::Plan(int returnType, const u8* paramTypes, std::size_t paramCount)
+{
+	CallPlan plan;
+	plan.pushers.reserve(paramCount);
+
+	for (std::size_t i = 0; i < paramCount; ++i)
+	{
+		if (paramTypes[i] & VMBREGISTER)
+		{
+			plan.pushers.push_back(RegisterPusher(paramTypes[i] & ~VMBREGISTER));
+			continue;
+		}
+
+		switch (paramTypes[i])
+		{
+		case VMBCHAR: plan.pushers.push_back([](DCCallVM* vm, const void* value) { dcArgChar(vm, *static_cast<const char*>(value)); }); break;
+		case VMBBOOL: plan.pushers.push_back([](DCCallVM* vm, const void* value) { dcArgBool(vm, *static_cast<const bool*>(value)); }); break;
+		case VMBSHORT: plan.pushers.push_back([](DCCallVM* vm, const void* value) { dcArgShort(vm, *static_cast<const short*>(value)); }); break;
+		case VMBINT: plan.pushers.push_back([](DCCallVM* vm, const void* value) { dcArgInt(vm, *static_cast<const int*>(value)); }); break;
+		case VMBLONG: plan.pushers.push_back([](DCCallVM* vm, const void* value) { dcArgLong(vm, *static_cast<const long*>(value)); }); break;
+		case VMBLONG_LONG: plan.pushers.push_back([](DCCallVM* vm, const void* value) { dcArgLongLong(vm, *static_cast<const long long*>(value)); }); break;
+		case VMBFLOAT: plan.pushers.push_back([](DCCallVM* vm, const void* value) { dcArgFloat(vm, *static_cast<const float*>(value)); }); break;
+		case VMBDOUBLE: plan.pushers.push_back([](DCCallVM* vm, const void* value) { dcArgDouble(vm, *static_cast<const double*>(value)); }); break;
+		case VMBPOINTER:
+		default: plan.pushers.push_back([](DCCallVM* vm, const void* value) { dcArgPointer(vm, const_cast<void*>(value)); }); break;
+		}
+	}
+
+	switch (returnType)
+	{
+	case VMBCHAR: plan.caller = [](DCCallVM* vm, void* funcPtr) { return Integer(dcCallChar(vm, funcPtr)); }; break;
+	case VMBBOOL: plan.caller = [](DCCallVM* vm, void* funcPtr) { return Integer(dcCallBool(vm, funcPtr)); }; break;
+	case VMBSHORT: plan.caller = [](DCCallVM* vm, void* funcPtr) { return Integer(dcCallShort(vm, funcPtr)); }; break;
+	case VMBINT: plan.caller = [](DCCallVM* vm, void* funcPtr) { return Integer(dcCallInt(vm, funcPtr)); }; break;
+	case VMBLONG: plan.caller = [](DCCallVM* vm, void* funcPtr) { return Integer(dcCallLong(vm, funcPtr)); }; break;
+	case VMBLONG_LONG: plan.caller = [](DCCallVM* vm, void* funcPtr) { return Integer(dcCallLongLong(vm, funcPtr)); }; break;
+	case VMBFLOAT: plan.caller = [](DCCallVM* vm, void* funcPtr) { return Real(dcCallFloat(vm, funcPtr)); }; break;
+	case VMBDOUBLE: plan.caller = [](DCCallVM* vm, void* funcPtr) { return Real(dcCallDouble(vm, funcPtr)); }; break;
+	case VMBPOINTER: plan.caller = [](DCCallVM* vm, void* funcPtr) { return Integer(static_cast<s64>(reinterpret_cast<std::uintptr_t>(dcCallPointer(vm, funcPtr)))); }; break;
+	case VMBVOID: plan.caller = [](DCCallVM* vm, void* funcPtr) { dcCallVoid(vm, funcPtr); return Integer(0); }; break;
+	default: break;
+	}
+
+	/*
+	 * Small libc functions like puts and strlen are called most often, their signatures don't need dyncall at all.
+	**/
+	if (plan.caller != nullptr) plan.direct = SelectTrampoline(returnType, paramTypes, paramCount);
+	return plan;
 }
\ No newline at end of file
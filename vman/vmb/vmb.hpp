@@ -23,16 +23,16 @@
  *
 **/
 
-#include <Windows.h>
-#include <Psapi.h>
-
 #include <iostream>
+#include <cstdint>
 #include <vector>
 #include <variant>
 #include <string>
+#include <string_view>
 #include <map>
 
 #include "../core/types.hpp"
+#include "platform.hpp"
 #include "dyncall/dyncall.h"
 #include "dyncall/dyncall_args.h"
 #include "dyncall/dyncall_callf.h"
@@ -50,25 +50,9 @@ namespace vman::vmb
 	class Bridge
 	{
 	private:
-		// A HANDLE to our own application, required for debugging purposes
-		HANDLE hProc;
 		DCCallVM* vm;
 
 	public:
-		/*
-		 * During the execution of a native function in runtime, virtual man
-		 * creates tokens that represent the parameters that will be pushed onto the stack.
-		 * Through this, virtual man decides as what datatype each value gets pushed onto the stack.
-		**/
-		struct Parameter
-		{
-			// VirtualMAN requires the type of the value, so it can push the value correctly to the stack
-			int paramType;
-
-			// This represents the value that VirtualMAN pushes to the stack before executing a function.
-			void* value;
-		};
-
 		/*
 		 * This defines a list of possible datatypes that can be handled by virtual man.
 		 * Note that VMBPOINTER is actually a char pointer representation inside virtual man.
@@ -84,70 +68,131 @@ namespace vman::vmb
 			VMBFLOAT = 0x06,
 			VMBDOUBLE = 0x07,
 			VMBPOINTER = 0x08,
+
+			// Only valid as return type, the result register is set to 0.
+			VMBVOID = 0x0A,
+
+			/*
+			 * Combined with a parameter type, the value is taken from the x register of the parameter,
+			 * or from its f register for float and double, instead of the binary.
+			**/
+			VMBREGISTER = 0x80,
+		};
+
+		/*
+		 * The result of a native call. Integers and pointers keep all of their 64 bits in integer,
+		 * floating point results are kept in real and rounded towards zero into integer.
+		**/
+		struct Result
+		{
+			s64 integer;
+			f64 real;
+		};
+
+		/*
+		 * The parameter and return types of a native call never change between two calls from the same place,
+		 * so the dyncall function for every value is chosen once when the call gets planned.
+		 * Calling through a plan only pushes the values and calls the function.
+		**/
+		struct CallPlan
+		{
+			using Pusher = void (*)(DCCallVM*, const void* value);
+			using Caller = Result (*)(DCCallVM*, void* funcPtr);
+			using Direct = Result (*)(void* funcPtr, const void* const* values);
+
+			// One function per parameter, it pushes the value as the type of the parameter.
+			std::vector<Pusher> pushers;
+
+			// Calls the function and converts its result, nullptr if the return type isn't supported.
+			Caller caller = nullptr;
+
+			/*
+			 * Calls the function with its exact C++ signature instead of going through dyncall,
+			 * only set for common signatures, see trampoline.hpp.
+			**/
+			Direct direct = nullptr;
 		};
 
 		Bridge(void);
 		~Bridge(void);
 
 		/*
-		 * This conversion first passes a pointer address to a large enough variable, which is a uintptr.
-		 * Depending on the compilation target, uintptr is either 4 bytes (32 bits) or 8 bytes (64 bits)
-		 * Then we cast to the target type, whose size ranges from 1 to 8 bytes.
-		 * This is mainly used to convert from void* to a target type.
+		 * Looks up a function inside an already loaded library, returns nullptr if either of them can't be found.
+		 * The lookup is expensive, callers are supposed to keep the result around instead of resolving the same symbol over and over again.
 		**/
-		#define doConvert(x) static_cast<T>(reinterpret_cast<std::uintptr_t>(x))
+		static void* ResolveSymbol(CCCSTR libName, CCCSTR funcName) noexcept;
+
+		static CallPlan Plan(int returnType, const u8* paramTypes, std::size_t paramCount);
 
 		/*
-		 * Due to the way on how a C++ handles translation units, we cannot create a templated function prototype
-		 * and create an implementation inside the source files, this is a drawback of C++.
+		 * The number of bytes a parameter of the given type reads from its value, a pointer reads at least one character.
 		**/
-		template<class T>
-		T CallNativeFunction(CCCSTR libName, CCCSTR funcName, const std::vector<Parameter>& params) noexcept
+		static constexpr std::size_t ValueSize(int type) noexcept
 		{
-			/*
-			 * Dyncall operates through its own virtual machine, however, it's entirely managed by VirtualMAN.
-			 * VirtualMAN decides according to the opcodes on what data is pushed into dyncall's stack and how a function is called.
-			**/
-			if (vm == nullptr)
+			switch (type)
 			{
-				vm = dcNewCallVM(4096);
-				if (vm == nullptr) return doConvert(nullptr);
-
-				/* 
-				 * This function determines the ABI target.
-				 * We're going to use the default target, this means that dyncall
-				 * tries to find out what ABI it is running on and then operates conform to the detected ABI.
-				**/
-				dcMode(vm, DC_CALL_C_DEFAULT);
+			case VMBCHAR: return sizeof(char);
+			case VMBBOOL: return sizeof(bool);
+			case VMBSHORT: return sizeof(short);
+			case VMBINT: return sizeof(int);
+			case VMBLONG: return sizeof(long);
+			case VMBLONG_LONG: return sizeof(long long);
+			case VMBFLOAT: return sizeof(float);
+			case VMBDOUBLE: return sizeof(double);
+			default: return sizeof(char);
 			}
+		}
 
-			/*
-			 * This function resets the dyncall stack
-			**/
-			dcReset(vm);
+		/*
+		 * The name of a type in assembly and disassembly, empty for unknown types.
+		**/
+		static constexpr std::string_view TypeName(int type) noexcept
+		{
+			switch (type)
+			{
+			case VMBCHAR: return "char";
+			case VMBBOOL: return "bool";
+			case VMBSHORT: return "short";
+			case VMBINT: return "int";
+			case VMBLONG: return "long";
+			case VMBLONG_LONG: return "long long";
+			case VMBFLOAT: return "float";
+			case VMBDOUBLE: return "double";
+			case VMBPOINTER: return "ptr";
+			case VMBVOID: return "void";
+			default: return {};
+			}
+		}
 
-			FARPROC funcPtr = GetProcAddress(GetModuleHandleA(libName), funcName);
-			printf("%s loaded at : 0x%p\n", libName, GetModuleHandleA("User32.dll"));
-			printf("%s loaded at: 0x%p\n", funcName, funcPtr);
-			if (funcPtr == nullptr) return doConvert(funcPtr);
+		/*
+		 * Calls a resolved function through its plan, values holds a pointer to the value of every parameter.
+		 * Parameters of a register type point to an s64 or an f64.
+		**/
+		Result Call(const CallPlan& plan, void* funcPtr, const void* const* values) noexcept
+		{
+			if (plan.direct != nullptr) return plan.direct(funcPtr, values);
 
-			for (size_t i = 0; i < params.size(); ++i)
+			dcReset(vm);
+			for (std::size_t i = 0; i < plan.pushers.size(); ++i)
 			{
-				switch (params[i].paramType)
-				{
-				case VMBCHAR: dcArgChar(vm, *reinterpret_cast<char*>(params[i].value)); break;
-				case VMBBOOL: dcArgBool(vm, *reinterpret_cast<bool*>(params[i].value)); break;
-				case VMBSHORT: dcArgShort(vm, *reinterpret_cast<short*>(params[i].value)); break;
-				case VMBINT: dcArgInt(vm, *reinterpret_cast<int*>(params[i].value)); break;
-				case VMBLONG: dcArgLong(vm, *reinterpret_cast<long*>(params[i].value)); break;
-				case VMBLONG_LONG: dcArgLongLong(vm, *reinterpret_cast<long long*>(params[i].value)); break;
-				case VMBPOINTER:
-				default: dcArgPointer(vm, params[i].value); break;
-				}
+				plan.pushers[i](vm, values[i]);
 			}
-			return doConvert(dcCallPointer(vm, funcPtr));
+			return plan.caller(vm, funcPtr);
 		}
+
 	};
+
+	/*
+	 * Rounds a double towards zero, NaN becomes 0 and values outside of the range of s64 saturate.
+	 * A plain conversion would be undefined for these values.
+	**/
+	constexpr s64 Truncate(f64 value) noexcept
+	{
+		if (value != value) return 0;
+		if (value >= 9223372036854775807.0) return INT64_MAX;
+		if (value <= -9223372036854775808.0) return INT64_MIN;
+		return static_cast<s64>(value);
+	}
 };
 
 #if defined (_MSC_VER)